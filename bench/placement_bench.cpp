@@ -0,0 +1,55 @@
+// Time simplify() on all hardware threads with each MemoryPlacement; on a
+// single-node machine they only differ by the cost of placing
+//
+// usage: placement_bench [torus rings = 600] [repetitions = 3]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include <numa.hpp>
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+int main(int argc, char* argv[]) {
+  const size_t rings = argc > 1 ? std::atoi(argv[1]) : 600;
+  const int repetitions = argc > 2 ? std::atoi(argv[2]) : 3;
+  Positions input;
+  Indices inputIndices;
+  torus(rings, rings / 2, 4, 1, {0, 0, 0}, input, inputIndices);
+  std::printf("%zu faces, %u NUMA nodes\n", inputIndices.size(),
+              Internal::NumaLayout().nodes());
+
+  const struct {
+    MemoryPlacement placement;
+    const char* name;
+  } placements[] = {{MemoryPlacement::FIRST_TOUCH, "first-touch"},
+                    {MemoryPlacement::INTERLEAVED, "interleaved"},
+                    {MemoryPlacement::PARTITIONED, "partitioned"}};
+  for (const auto& p : placements) {
+    SimplifyOptions options;
+    options.strength = 0.9f;
+    options.threads = 0;
+    options.placement = p.placement;
+    double best = 1e300;
+    uint64_t outputHash = 0;
+    for (int r = 0; r < repetitions; ++r) {
+      Positions positions = input;
+      Indices indices = inputIndices;
+      const auto start = std::chrono::steady_clock::now();
+      simplify(positions, indices, options);
+      const std::chrono::duration<double, std::milli> time =
+          std::chrono::steady_clock::now() - start;
+      best = std::min(best, time.count());
+      outputHash = hash(positions, indices);
+    }
+    std::printf("%-12s %9.1f ms  output %016llx\n", p.name, best,
+                static_cast<unsigned long long>(outputHash));
+  }
+  return 0;
+}
@@ -0,0 +1,88 @@
+// Compare the priority queues of edges: throughput and error of simplify()
+// with the exact heap and with buckets of several widths, and the time per
+// mesh of a Simplifier reused for many small meshes, which resets its queue
+// between them
+//
+// usage: queue_bench [torus rings = 600] [small meshes = 2000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include <simplifier.hpp>
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+static const double R = 4, r = 1;
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+  const std::chrono::duration<double, std::milli> time =
+      std::chrono::steady_clock::now() - start;
+  return time.count();
+}
+
+int main(int argc, char* argv[]) {
+  const size_t rings = argc > 1 ? std::atoi(argv[1]) : 600;
+  const size_t smallMeshes = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+  Positions input;
+  Indices inputIndices;
+  torus(rings, rings / 2, R, r, {0, 0, 0}, input, inputIndices);
+  std::printf("%zu faces at strength 0.9, one thread\n", inputIndices.size());
+  std::printf("%-14s %10s %14s %12s\n", "queue", "time (ms)", "collapses/s",
+              "max error");
+
+  for (float width : {0.0f, 0.001f, 0.01f, 0.1f}) {
+    SimplifyOptions options;
+    options.strength = 0.9f;
+    options.threads = 1;
+    options.bucketWidth = width;
+    double best = 1e300, error = 0;
+    for (int repetition = 0; repetition < 3; ++repetition) {
+      Positions positions = input;
+      Indices indices = inputIndices;
+      const auto start = std::chrono::steady_clock::now();
+      simplify(positions, indices, options);
+      best = std::min(best, millisecondsSince(start));
+      error = torusError(positions, R, r, {0, 0, 0});
+    }
+    // a collapse removes two faces
+    const double collapses = 0.9 * inputIndices.size() / 2;
+    char name[32];
+    if (width > 0)
+      std::snprintf(name, sizeof(name), "buckets %g", width);
+    else
+      std::snprintf(name, sizeof(name), "heap");
+    std::printf("%-14s %10.1f %14.0f %12.3e\n", name, best,
+                collapses / best * 1000, error);
+  }
+
+  Positions small;
+  Indices smallIndices;
+  torus(20, 10, R, r, {0, 0, 0}, small, smallIndices);
+  std::printf("\n%zu meshes of %zu faces with one Simplifier\n", smallMeshes,
+              smallIndices.size());
+  for (float width : {0.0f, 0.1f, 0.001f}) {
+    SimplifyOptions options;
+    options.strength = 0.5f;
+    options.threads = 1;
+    options.bucketWidth = width;
+    Simplifier simplifier(options);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t m = 0; m < smallMeshes; ++m)
+      simplifier.simplify(small, smallIndices);
+    const double time = millisecondsSince(start) * 1000 / smallMeshes;
+    char name[32];
+    if (width > 0)
+      std::snprintf(name, sizeof(name), "buckets %g", width);
+    else
+      std::snprintf(name, sizeof(name), "heap");
+    std::printf("%-14s %10.1f us per mesh\n", name, time);
+  }
+  return 0;
+}
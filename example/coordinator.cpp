@@ -0,0 +1,618 @@
+// Sharded simplification of meshes that do not fit in the memory of one
+// process.
+//
+// `shard` splits the input into a grid of spatial chunks on disk, `work`
+// simplifies one chunk with the vertices it shares with other chunks locked,
+// and `merge` welds the chunk outputs back together and runs a cleanup pass on
+// the band around chunk borders, which the workers were not allowed to touch.
+// `run` does all three on this machine, launching one worker process per
+// chunk.
+//
+// Stages communicate only through files in a work directory, so `work` can be
+// scheduled on any machine sharing that directory:
+//    manifest.txt        chunk count, input face count and options
+//    chunk<k>.obj        input of chunk k
+//    chunk<k>.fixed      locked vertices of chunk k, one per line: its 1-based
+//                        index in the chunk and 0-based index in the input
+//    chunk<k>.out.obj    output of chunk k
+//    chunk<k>.out.fixed  locked vertices of the output of chunk k, likewise
+//
+// Sharding does not hold the positions of the input in memory: they are
+// spilled to disk and read back per chunk.
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <queue>
+#include <simplify.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <types.hpp>
+#include <vector>
+
+#include "clipp.h"
+#include "obj.hpp"
+
+using namespace std;
+using namespace clipp;
+using namespace MeshSimpl;
+
+struct Manifest {
+  unsigned resolution = 2;  // chunks per axis
+  size_t faceCount = 0;     // of the whole input
+  vector<unsigned> chunks;  // ids of non-empty chunks
+};
+
+string chunkPath(const string& dir, unsigned k, const string& suffix);
+
+void writeManifest(const string& dir, const Manifest& manifest,
+                   const SimplifyOptions& options);
+
+Manifest readManifest(const string& dir, SimplifyOptions& options);
+
+void shard(const string& in, const string& dir, unsigned resolution,
+           const SimplifyOptions& options);
+
+void work(const string& dir, unsigned k);
+
+void runWorkers(const string& dir, const vector<unsigned>& chunks,
+                unsigned jobs);
+
+void merge(const string& dir, const string& out);
+
+int main(int argc, char* argv[]) {
+  string in, out, dir = "shards";
+  unsigned resolution = 2, jobs = 0, chunk = 0;
+  SimplifyOptions options;
+  enum class Mode { RUN, SHARD, WORK, MERGE } mode = Mode::RUN;
+
+  auto simplifyOpts = (
+      // clang-format off
+      (option("-s", "--strength") & number("ratio", options.strength))
+       % "0.8 means remove 80% faces",
+      (option("-w", "--weight-by-area").set(options.weightByArea))
+       % "quadrics are scaled by triangle area",
+      (option("--border-constraint") & number("constant", options.borderConstraint))
+       % "weight of constraint planes on mesh boundary",
+      (option("--aspect-ratio") & number("ratio", options.aspectRatioThreshold))
+       % "faces with aspect ratio larger than 1/ratio won't be created",
+      (option("-j", "--threads") & number("count", options.threads))
+       % "number of threads planning edge collapses in each process"
+      // clang-format on
+  );
+  auto shardOpts = (
+      // clang-format off
+      (option("-d", "--dir") & value("dir", dir))
+       % "work directory holding chunks (default to shards)",
+      (option("-c", "--chunks") & number("n", resolution))
+       % "split bounding box into n*n*n chunks (default to 2)"
+      // clang-format on
+  );
+
+  auto cli = (
+      // clang-format off
+      (command("run").set(mode, Mode::RUN),
+       value("input", in) % "input .obj file path",
+       value("output", out) % "output .obj file path",
+       shardOpts, simplifyOpts,
+       (option("-p", "--processes") & number("count", jobs))
+        % "number of concurrent worker processes; 0 for one per hardware thread") |
+      (command("shard").set(mode, Mode::SHARD),
+       value("input", in) % "input .obj file path",
+       shardOpts, simplifyOpts) |
+      (command("work").set(mode, Mode::WORK),
+       value("dir", dir) % "work directory",
+       number("chunk", chunk) % "id of chunk to simplify") |
+      (command("merge").set(mode, Mode::MERGE),
+       value("dir", dir) % "work directory",
+       value("output", out) % "output .obj file path")
+      // clang-format on
+  );
+
+  if (!parse(argc, argv, cli)) {
+    cout << make_man_page(cli, argv[0]);
+    return 1;
+  }
+
+  try {
+    const auto before = chrono::steady_clock::now();
+    switch (mode) {
+      case Mode::SHARD:
+        shard(in, dir, resolution, options);
+        break;
+      case Mode::WORK:
+        work(dir, chunk);
+        break;
+      case Mode::MERGE:
+        merge(dir, out);
+        break;
+      case Mode::RUN: {
+        shard(in, dir, resolution, options);
+        Manifest manifest = readManifest(dir, options);
+        runWorkers(dir, manifest.chunks, jobs);
+        merge(dir, out);
+        break;
+      }
+    }
+    const auto after = chrono::steady_clock::now();
+    if (mode != Mode::WORK)
+      cout << "Completed ("
+           << chrono::duration_cast<chrono::milliseconds>(after - before)
+                  .count()
+           << " ms)" << endl;
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+string chunkPath(const string& dir, unsigned k, const string& suffix) {
+  return dir + "/chunk" + to_string(k) + suffix;
+}
+
+// Files open at a time for the chunks, so that the number of chunks is not
+// limited by the number of file descriptors
+const size_t MAX_OPEN_FILES = 64;
+
+// Faces held in memory before they are appended to chunk files
+const size_t FACE_BATCH = 1 << 16;
+
+const idx NONE = numeric_limits<idx>::max();
+
+FILE* openFile(const string& path, const char* mode) {
+  FILE* file = fopen(path.c_str(), mode);
+  if (file == nullptr)
+    throw runtime_error("ERROR::COORDINATOR: cannot open " + path);
+  return file;
+}
+
+// Append items to a binary file, opened only for this
+template <typename T>
+void appendItems(const string& path, const vector<T>& items) {
+  FILE* file = openFile(path, "ab");
+  fwrite(items.data(), sizeof(T), items.size(), file);
+  fclose(file);
+}
+
+template <typename T>
+vector<T> readItems(const string& path) {
+  vector<T> items;
+  FILE* file = openFile(path, "rb");
+  T item;
+  while (fread(&item, sizeof(T), 1, file) == 1) items.push_back(item);
+  fclose(file);
+  return items;
+}
+
+// Merge files of sorted vertex ids into one; if `sharedOnly`, only ids found
+// more than once are written, once each
+void mergeIds(const vector<string>& paths, const string& out,
+              bool sharedOnly) {
+  vector<FILE*> files;
+  typedef pair<idx, size_t> Head;  // next id of a file and the file
+  priority_queue<Head, vector<Head>, greater<Head>> heads;
+  for (const string& path : paths) {
+    files.push_back(openFile(path, "rb"));
+    idx v;
+    if (fread(&v, sizeof(idx), 1, files.back()) == 1)
+      heads.push({v, files.size() - 1});
+  }
+
+  FILE* merged = openFile(out, "wb");
+  idx last = NONE;
+  size_t count = 0;
+  const auto flush = [&] {
+    if (sharedOnly && count > 1)
+      fwrite(&last, sizeof(idx), 1, merged);
+    else if (!sharedOnly)
+      for (size_t i = 0; i < count; ++i) fwrite(&last, sizeof(idx), 1, merged);
+  };
+  while (!heads.empty()) {
+    const Head head = heads.top();
+    heads.pop();
+    if (head.first != last) {
+      flush();
+      last = head.first;
+      count = 0;
+    }
+    ++count;
+    idx v;
+    if (fread(&v, sizeof(idx), 1, files[head.second]) == 1)
+      heads.push({v, head.second});
+  }
+  flush();
+  fclose(merged);
+  for (FILE* file : files) fclose(file);
+}
+
+// Write the ids found in more than one of the files of sorted vertex ids to
+// `out`, merging at most MAX_OPEN_FILES at a time
+void findShared(vector<string> paths, const string& dir, const string& out) {
+  vector<string> temporary;
+  while (paths.size() > MAX_OPEN_FILES) {
+    vector<string> merged;
+    for (size_t b = 0; b < paths.size(); b += MAX_OPEN_FILES) {
+      const size_t e = min(paths.size(), b + MAX_OPEN_FILES);
+      merged.push_back(dir + "/merge" + to_string(temporary.size()) + ".ids");
+      temporary.push_back(merged.back());
+      mergeIds(vector<string>(paths.begin() + b, paths.begin() + e),
+               merged.back(), false);
+    }
+    paths = merged;
+  }
+  mergeIds(paths, out, true);
+  for (const string& path : temporary) remove(path.c_str());
+}
+
+// Parse a face line of .obj file in the same way as load_obj() does
+vec3i parseFace(stringstream& ss) {
+  vec3i face;
+  for (int i = 0; i < 3; ++i) {
+    ss >> face[i];
+    char ch;
+    do {
+      ch = ss.get();
+    } while (!ss.eof() && ch != ' ');
+  }
+  for (int i = 0; i < 3; ++i) --face[i];
+  return face;
+}
+
+void writeManifest(const string& dir, const Manifest& manifest,
+                   const SimplifyOptions& options) {
+  ofstream ofs(dir + "/manifest.txt");
+  ofs << setprecision(numeric_limits<double>::max_digits10);
+  ofs << "resolution " << manifest.resolution << endl
+      << "faces " << manifest.faceCount << endl
+      << "strength " << options.strength << endl
+      << "weight-by-area " << options.weightByArea << endl
+      << "border-constraint " << options.borderConstraint << endl
+      << "aspect-ratio " << options.aspectRatioThreshold << endl
+      << "threads " << options.threads << endl
+      << "chunks";
+  for (unsigned k : manifest.chunks) ofs << " " << k;
+  ofs << endl;
+  if (!ofs) throw runtime_error("ERROR::COORDINATOR: cannot write manifest");
+}
+
+Manifest readManifest(const string& dir, SimplifyOptions& options) {
+  ifstream ifs(dir + "/manifest.txt");
+  if (!ifs) throw runtime_error("ERROR::COORDINATOR: cannot read manifest");
+
+  Manifest manifest;
+  string key;
+  while (ifs >> key) {
+    if (key == "resolution") {
+      ifs >> manifest.resolution;
+    } else if (key == "faces") {
+      ifs >> manifest.faceCount;
+    } else if (key == "strength") {
+      ifs >> options.strength;
+    } else if (key == "weight-by-area") {
+      ifs >> options.weightByArea;
+    } else if (key == "border-constraint") {
+      ifs >> options.borderConstraint;
+    } else if (key == "aspect-ratio") {
+      ifs >> options.aspectRatioThreshold;
+    } else if (key == "threads") {
+      ifs >> options.threads;
+    } else if (key == "chunks") {
+      string line;
+      getline(ifs, line);
+      stringstream ss(line);
+      copy(istream_iterator<unsigned>(ss), istream_iterator<unsigned>(),
+           back_inserter(manifest.chunks));
+    }
+  }
+  return manifest;
+}
+
+void shard(const string& in, const string& dir, unsigned resolution,
+           const SimplifyOptions& options) {
+  if (resolution == 0)
+    throw invalid_argument("ERROR::COORDINATOR: chunk count must be positive");
+  mkdir(dir.c_str(), 0755);
+
+  // first pass: bounding box, with positions spilled to disk
+  const string positionsPath = dir + "/positions.bin";
+  size_t nv = 0;
+  vec3d lo, hi;
+  lo.fill(numeric_limits<double>::max());
+  hi.fill(numeric_limits<double>::lowest());
+  {
+    ifstream ifs(in);
+    if (!ifs) throw runtime_error("ERROR::COORDINATOR: cannot read " + in);
+    FILE* positions = openFile(positionsPath, "wb");
+    for (string line; getline(ifs, line);) {
+      if (line.compare(0, 2, "v ") != 0) continue;
+      stringstream ss(line.substr(2));
+      vec3d pos;
+      ss >> pos[0] >> pos[1] >> pos[2];
+      fwrite(pos.data(), sizeof(double), 3, positions);
+      ++nv;
+      for (int i = 0; i < 3; ++i) {
+        lo[i] = min(lo[i], pos[i]);
+        hi[i] = max(hi[i], pos[i]);
+      }
+    }
+    fclose(positions);
+  }
+
+  // cell of every vertex in the grid of chunks
+  const unsigned nChunks = resolution * resolution * resolution;
+  vector<unsigned> cells(nv);
+  {
+    FILE* positions = openFile(positionsPath, "rb");
+    vec3d pos;
+    for (idx v = 0; v < nv; ++v) {
+      if (fread(pos.data(), sizeof(double), 3, positions) != 3)
+        throw runtime_error("ERROR::COORDINATOR: cannot read positions");
+      unsigned k = 0;
+      for (int i = 2; i >= 0; --i) {
+        const double extent = hi[i] - lo[i];
+        unsigned cell =
+            extent > 0
+                ? static_cast<unsigned>((pos[i] - lo[i]) / extent * resolution)
+                : 0;
+        k = k * resolution + min(cell, resolution - 1);
+      }
+      cells[v] = k;
+    }
+    fclose(positions);
+  }
+
+  // second pass: stream faces into chunk files in batches, so that one file
+  // is open at a time; a face goes to the cell of two or three of its
+  // vertices, or else of the first
+  Manifest manifest;
+  manifest.resolution = resolution;
+  {
+    vector<vector<vec3i>> batches(nChunks);
+    vector<bool> used(nChunks, false);
+    size_t batched = 0;
+    const auto flush = [&] {
+      for (unsigned k = 0; k < nChunks; ++k) {
+        if (batches[k].empty()) continue;
+        appendItems(chunkPath(dir, k, ".faces"), batches[k]);
+        batches[k].clear();
+      }
+      batched = 0;
+    };
+
+    ifstream ifs(in);
+    for (string line; getline(ifs, line);) {
+      if (line.compare(0, 2, "f ") != 0) continue;
+      stringstream ss(line.substr(2));
+      const vec3i face = parseFace(ss);
+      for (idx v : face)
+        if (v >= nv)
+          throw runtime_error("ERROR::COORDINATOR: face of a missing vertex");
+
+      const unsigned k = cells[face[1]] == cells[face[2]] ? cells[face[1]]
+                                                          : cells[face[0]];
+      if (!used[k]) {
+        used[k] = true;
+        remove(chunkPath(dir, k, ".faces").c_str());
+        manifest.chunks.push_back(k);
+      }
+      batches[k].push_back(face);
+      ++manifest.faceCount;
+      if (++batched == FACE_BATCH) flush();
+    }
+    flush();
+  }
+  vector<unsigned>().swap(cells);
+  sort(manifest.chunks.begin(), manifest.chunks.end());
+
+  // vertices of every chunk, sorted, and those found in more than one
+  vector<string> idsPaths;
+  for (unsigned k : manifest.chunks) {
+    vector<idx> global;
+    for (const vec3i& face : readItems<vec3i>(chunkPath(dir, k, ".faces")))
+      global.insert(global.end(), face.begin(), face.end());
+    sort(global.begin(), global.end());
+    global.erase(unique(global.begin(), global.end()), global.end());
+    idsPaths.push_back(chunkPath(dir, k, ".ids"));
+    remove(idsPaths.back().c_str());
+    appendItems(idsPaths.back(), global);
+  }
+  const string sharedPath = dir + "/shared.ids";
+  findShared(idsPaths, dir, sharedPath);
+
+  // write every chunk as a standalone mesh with its shared vertices locked,
+  // reading its positions from disk
+  for (unsigned k : manifest.chunks) {
+    const string facesPath = chunkPath(dir, k, ".faces");
+    const string idsPath = chunkPath(dir, k, ".ids");
+    vector<vec3i> indices = readItems<vec3i>(facesPath);
+    const vector<idx> global = readItems<idx>(idsPath);
+    remove(facesPath.c_str());
+    remove(idsPath.c_str());
+
+    for (auto& face : indices)
+      for (auto& v : face)
+        v = lower_bound(global.begin(), global.end(), v) - global.begin();
+
+    vector<vec3d> local(global.size());
+    FILE* positions = openFile(positionsPath, "rb");
+    for (idx v = 0; v < global.size(); ++v) {
+      fseek(positions, global[v] * sizeof(vec3d), SEEK_SET);
+      if (fread(local[v].data(), sizeof(double), 3, positions) != 3)
+        throw runtime_error("ERROR::COORDINATOR: cannot read positions");
+    }
+    fclose(positions);
+
+    // walk the sorted ids of the chunk and of shared vertices together
+    ofstream fixed(chunkPath(dir, k, ".fixed"));
+    FILE* shared = openFile(sharedPath, "rb");
+    idx s;
+    bool more = fread(&s, sizeof(idx), 1, shared) == 1;
+    for (idx v = 0; v < global.size() && more; ++v) {
+      while (more && s < global[v])
+        more = fread(&s, sizeof(idx), 1, shared) == 1;
+      if (more && s == global[v]) fixed << v + 1 << " " << s << endl;
+    }
+    fclose(shared);
+    write_to_obj(chunkPath(dir, k, ".obj"), local, indices);
+  }
+  remove(sharedPath.c_str());
+  remove(positionsPath.c_str());
+
+  writeManifest(dir, manifest, options);
+  cout << "Sharded mesh (#V = " << nv << "; #F = " << manifest.faceCount
+       << ") into " << manifest.chunks.size() << " chunks in " << dir << endl;
+}
+
+// A vertex of a chunk: its position, followed by its index in the input of
+// the chunk, which the output vertex standing for it takes along
+struct ChunkVertex {
+  vec3d position;
+  idx local;
+};
+
+void work(const string& dir, unsigned k) {
+  SimplifyOptions options;
+  readManifest(dir, options);
+
+  vector<vec3d> positions;
+  vector<vec3i> indices;
+  load_obj(chunkPath(dir, k, ".obj"), positions, indices);
+
+  options.fixedVertices.assign(positions.size(), false);
+  vector<idx> global(positions.size(), NONE);
+  ifstream fixed(chunkPath(dir, k, ".fixed"));
+  for (idx v, g; fixed >> v >> g;) {
+    options.fixedVertices[v - 1] = true;
+    global[v - 1] = g;
+  }
+
+  // simplify in a buffer of ChunkVertex to find out which input vertex each
+  // output vertex stands for
+  vector<ChunkVertex> vertices(positions.size());
+  for (idx v = 0; v < positions.size(); ++v) vertices[v] = {positions[v], v};
+  vector<idx> flat;
+  for (const auto& face : indices)
+    flat.insert(flat.end(), face.begin(), face.end());
+  VertexBuffer buffer;
+  buffer.data = vertices.data();
+  buffer.count = vertices.size();
+  buffer.stride = sizeof(ChunkVertex);
+  buffer.doublePrecision = true;
+  const MeshSize size = simplify(buffer, flat.data(), indices.size(), options);
+
+  positions.resize(size.vertices);
+  ofstream outFixed(chunkPath(dir, k, ".out.fixed"));
+  for (idx v = 0; v < size.vertices; ++v) {
+    positions[v] = vertices[v].position;
+    if (global[vertices[v].local] != NONE)
+      outFixed << v + 1 << " " << global[vertices[v].local] << endl;
+  }
+  indices.resize(size.faces);
+  for (size_t f = 0; f < size.faces; ++f)
+    for (order j = 0; j < 3; ++j) indices[f][j] = flat[3 * f + j];
+  write_to_obj(chunkPath(dir, k, ".out.obj"), positions, indices);
+}
+
+void runWorkers(const string& dir, const vector<unsigned>& chunks,
+                unsigned jobs) {
+  if (jobs == 0) jobs = max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+
+  size_t next = 0, running = 0;
+  bool failed = false;
+  while (next < chunks.size() || running > 0) {
+    if (next < chunks.size() && running < jobs && !failed) {
+      const string chunk = to_string(chunks[next++]);
+      const pid_t pid = fork();
+      if (pid == 0) {
+        execl("/proc/self/exe", "coordinator", "work", dir.c_str(),
+              chunk.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+      }
+      if (pid < 0) throw runtime_error("ERROR::COORDINATOR: fork failed");
+      ++running;
+      continue;
+    }
+
+    int status;
+    if (wait(&status) < 0) break;
+    --running;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = true;
+  }
+
+  if (failed) throw runtime_error("ERROR::COORDINATOR: a worker failed");
+}
+
+void merge(const string& dir, const string& out) {
+  SimplifyOptions options;
+  const Manifest manifest = readManifest(dir, options);
+
+  // locked vertices are welded by their index in the input, which workers
+  // write along with them
+  map<idx, idx> welded;
+  vector<vec3d> positions;
+  vector<vec3i> indices;
+  vector<bool> border;
+  for (unsigned k : manifest.chunks) {
+    vector<vec3d> chunkPositions;
+    vector<vec3i> chunkIndices;
+    load_obj(chunkPath(dir, k, ".out.obj"), chunkPositions, chunkIndices);
+    vector<idx> global(chunkPositions.size(), NONE);
+    ifstream fixed(chunkPath(dir, k, ".out.fixed"));
+    for (idx v, g; fixed >> v >> g;) global[v - 1] = g;
+
+    vector<idx> local2global(chunkPositions.size());
+    for (idx v = 0; v < chunkPositions.size(); ++v) {
+      if (global[v] != NONE) {
+        auto it = welded.find(global[v]);
+        if (it != welded.end()) {
+          local2global[v] = it->second;
+          continue;
+        }
+        welded.emplace(global[v], positions.size());
+      }
+      local2global[v] = positions.size();
+      positions.push_back(chunkPositions[v]);
+      border.push_back(global[v] != NONE);
+    }
+
+    for (auto& face : chunkIndices) {
+      for (auto& v : face) v = local2global[v];
+      indices.push_back(face);
+    }
+  }
+
+  // cleanup: simplify the band around chunk borders, i.e., the vertices
+  // locked by workers and their neighbors, towards the overall target
+  const size_t target =
+      manifest.faceCount - lround(options.strength * manifest.faceCount);
+  if (indices.size() > target) {
+    options.fixedVertices.assign(positions.size(), true);
+    for (const auto& face : indices) {
+      if (border[face[0]] || border[face[1]] || border[face[2]])
+        for (idx v : face) options.fixedVertices[v] = false;
+    }
+    options.strength = 1.0f - static_cast<float>(target) / indices.size();
+    simplify(positions, indices, options);
+  }
+
+  write_to_obj(out, positions, indices);
+  cout << "Merged " << manifest.chunks.size() << " chunks (#V = "
+       << positions.size() << "; #F = " << indices.size() << ") to " << out
+       << endl;
+}
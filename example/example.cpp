@@ -1,32 +1,134 @@
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory.hpp>
+#include <progressive.hpp>
+#include <new>
+#include <stdexcept>
+#include <simplifier.hpp>
 #include <simplify.hpp>
+#include <sstream>
+#include <stream.hpp>
 #include <string>
 #include <types.hpp>
 #include <vector>
 
 #include "clipp.h"
+#include "obj.hpp"
 
 using namespace std;
 using namespace clipp;
 using namespace MeshSimpl;
 
-void load_obj(const string& filename, vector<vec3d>& positions,
-              vector<vec3i>& indices);
+// Allocations made so far, reported by --repeat and --arena
+static atomic<size_t> allocations(0);
 
-void write_to_obj(const string& filename, const vector<vec3d>& positions,
-                  const vector<vec3i>& indices);
+void* operator new(size_t size) {
+  allocations.fetch_add(1, memory_order_relaxed);
+  if (void* p = malloc(size > 0 ? size : 1)) return p;
+  throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
 
 void specifyFixedVertices(const string& filename, vector<bool>& fixed);
+void streamObj(const string& filename, StreamSimplifier& simplifier);
+
+// Simplify a vertex buffer with indices narrowed or widened to type I
+template <typename I>
+MeshSize simplifyBuffer(const VertexBuffer& buffer, vector<idx>& indices,
+                        const SimplifyOptions& options) {
+  vector<I> converted(indices.begin(), indices.end());
+  const MeshSize size =
+      simplify(buffer, converted.data(), converted.size() / 3, options);
+  indices.assign(converted.begin(), converted.begin() + size.faces * 3);
+  return size;
+}
+
+// Writes an .obj file as the mesh comes, counting what was written
+class ObjSink : public MeshSink {
+ public:
+  explicit ObjSink(const string& filename) : ofs(filename) {
+    ofs << fixed << setprecision(9);
+  }
+
+  void vertex(const vec3d& position) override {
+    ofs << "v " << position[0] << " " << position[1] << " " << position[2]
+        << "\n";
+    ++nv;
+  }
+
+  void face(const vec3i& face) override {
+    ofs << "f " << face[0] + 1 << " " << face[1] + 1 << " " << face[2] + 1
+        << "\n";
+    ++nf;
+  }
+
+  size_t nv = 0, nf = 0;
+
+ private:
+  ofstream ofs;
+};
+
+// Triangle soup in a binary file of 9 doubles per triangle, read in chunks
+class SoupFile : public TriangleSource {
+ public:
+  explicit SoupFile(const string& filename)
+      : ifs(filename, ios::binary), chunk(1 << 14) {
+    if (!ifs) throw runtime_error("cannot open " + filename);
+  }
+
+  void rewind() override {
+    ifs.clear();
+    ifs.seekg(0);
+    begin = end = 0;
+  }
+
+  bool next(array<vec3d, 3>& corners) override {
+    if (begin == end) {
+      ifs.read(reinterpret_cast<char*>(chunk.data()),
+               chunk.size() * sizeof(chunk[0]));
+      begin = 0;
+      end = ifs.gcount() / sizeof(chunk[0]);
+      if (end == 0) return false;
+    }
+    corners = chunk[begin++];
+    return true;
+  }
+
+ private:
+  ifstream ifs;
+  vector<array<vec3d, 3>> chunk;
+  size_t begin = 0, end = 0;
+};
 
 int main(int argc, char* argv[]) {
   string in, out, fixedVerticesFile;
   SimplifyOptions options;
+  IsaLevel isa = isaLevel();
+  bool byComponent = false, shareBudget = false, singlePrecision = false;
+  bool interleaved = false;
+  unsigned indexBits = 32;
+  bool twoPhase = false;
+  bool indexOnly = false;
+  vector<float> lodStrengths;
+  bool progressive = false;
+  unsigned repeat = 0;
+  unsigned arenaRuns = 0;
+  unsigned clusterResolution = 0;
+  OutOfCoreOptions outOfCore;
+  size_t memoryBudgetMiB = 0;
+  size_t streamWindow = 0;
+  Heightfield field;
 
   auto cli = (
       // clang-format off
@@ -40,6 +142,8 @@ int main(int argc, char* argv[]) {
        % "permit change of topology during simplification",
       (option("-w", "--weight-by-area").set(options.weightByArea))
        % "quadrics are scaled by triangle area",
+      (option("-m", "--memoryless").set(options.memoryless))
+       % "store no quadrics; errors are measured against the current faces around an edge",
       (option("-s", "--strength") & number("ratio", options.strength))
        % "0.8 means remove 80% vertices",
       (option("--border-constraint") & number("constant", options.borderConstraint))
@@ -47,7 +151,56 @@ int main(int argc, char* argv[]) {
       (option("--aspect-ratio") & number("ratio", options.aspectRatioThreshold))
        % ("faces with aspect ratio larger than 1/ratio won't be created; assign non-positive value to disable the checking (default to " + to_string(options.aspectRatioThreshold) + ")"),
       (option("--fixed-vertices") & value("file", fixedVerticesFile))
-       % "a file with a vertex number on each line, included vertices will be fixed during the simplification"
+       % "a file with a vertex number on each line, included vertices will be fixed during the simplification",
+      (option("--candidates") & number("count", options.candidates))
+       % "collapse the best of this many random edges instead of keeping a heap of all edges; faster but less accurate",
+      (option("--bucket-width") & number("width", options.bucketWidth))
+       % "collapse edges whose errors are within this relative width of each other in any order; faster but less accurate",
+      (option("-j", "--threads") & number("count", options.threads))
+       % "number of threads planning edge collapses; 0 for all hardware threads (default to 1)",
+      (option("--placement") & (required("first-touch").set(options.placement, MemoryPlacement::FIRST_TOUCH) |
+                                required("interleaved").set(options.placement, MemoryPlacement::INTERLEAVED) |
+                                required("partitioned").set(options.placement, MemoryPlacement::PARTITIONED)))
+       % "placement of internal arrays on NUMA nodes (default to first-touch)",
+      (option("--float").set(singlePrecision))
+       % "simplify in single precision: positions are rounded to float, and positions and quadrics are stored in float",
+      (option("--interleaved").set(interleaved))
+       % "simplify in-place in a vertex buffer interleaving positions with normals and texture coordinates, in float if --float",
+      (option("--index-bits") & number("bits", indexBits))
+       % "with --interleaved, pass indices of 16, 32 or 64 bits (default to 32)",
+      (option("--index-only").set(indexOnly))
+       % "keep the input vertices and only compute new indices into them, as a level of detail sharing the vertex buffer; unused vertices are written too",
+      (option("--lods") & numbers("ratios", lodStrengths))
+       % "simplify in one run into levels of detail of these strengths, from fine to coarse, and write level l to the output path with .l before its extension; with --index-only, levels share the input vertices",
+      (option("--progressive").set(progressive))
+       % "log the collapses, write the log next to the output path with extension .log, and report how fast it refines the output back into the input and coarsens it again",
+      (option("--two-phase").set(twoPhase))
+       % "query the size of the result first and write it into buffers allocated for it",
+      (option("--repeat") & number("runs", repeat))
+       % "as --two-phase, simplify the mesh this many times reusing one simplifier and report the time and allocations of each run",
+      (option("--arena") & number("runs", arenaRuns))
+       % "simplify the mesh this many times from the global heap and as many times from an arena released after each run, and compare their time and allocations",
+      (option("--components").set(byComponent))
+       % "simplify connected components separately and concurrently",
+      (option("--share-budget").set(shareBudget))
+       % "with --components, components compete for the total face budget instead of each keeping 1-strength of its faces",
+      (option("--heightfield") & number("width", field.width) & number("height", field.height))
+       % "input is a text file of width x height heights in row-major order, simplified as a grid with locked border",
+      (option("--planar").set(options.planarRegions))
+       % "first retriangulate flat regions without their interior vertices, e.g., for CAD meshes",
+      (option("--cluster-factor") & number("factor", options.clusterFactor))
+       % "for heavy reductions, cluster vertices down to this many times the target face count before edge collapse",
+      (option("--cluster") & number("resolution", clusterResolution))
+       % "simplify by vertex clustering on a grid of this many cells along the longest side instead of edge collapse; --strength is ignored",
+      (option("--out-of-core") & number("MiB", memoryBudgetMiB) & number("faces", outOfCore.faces))
+       % "input is a binary file of 9 doubles per triangle, simplified out of core in this much memory to about this many faces",
+      (option("--stream") & number("faces", streamWindow))
+       % "stream the .obj in file order through a window of about this many faces and write the output as it comes; a line 'x i' finalizes vertex i",
+      (option("--isa") & (required("generic").set(isa, IsaLevel::GENERIC) |
+                          required("sse4.2").set(isa, IsaLevel::SSE42) |
+                          required("avx2").set(isa, IsaLevel::AVX2) |
+                          required("avx512").set(isa, IsaLevel::AVX512)))
+       % "force the instruction set of vectorized kernels (default to the best supported)"
       // clang-format on
        );
 
@@ -57,13 +210,33 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
+  try {
+    setIsaLevel(isa);
+  } catch (const invalid_argument& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
   vector<vec3d> positions;
   vector<vec3i> indices;
 
-  // read obj file
-  load_obj(in, positions, indices);
-  cout << "Loaded mesh (#V = " << positions.size()
-       << "; #F = " << indices.size() << ") from " << in << endl;
+  if (memoryBudgetMiB > 0 || streamWindow > 0) {
+    // the input is streamed during simplification
+    outOfCore.memoryBudget = memoryBudgetMiB << 20;
+    outOfCore.threads = options.threads;
+  } else if (field.width > 0) {
+    // read heights
+    ifstream ifs(in);
+    copy(istream_iterator<double>(ifs), istream_iterator<double>(),
+         back_inserter(field.heights));
+    cout << "Loaded heightfield (" << field.width << " x " << field.height
+         << ") from " << in << endl;
+  } else {
+    // read obj file
+    load_obj(in, positions, indices);
+    cout << "Loaded mesh (#V = " << positions.size()
+         << "; #F = " << indices.size() << ") from " << in << endl;
+  }
 
   if (!fixedVerticesFile.empty()) {
     // fix vertices according to given file
@@ -72,14 +245,197 @@ int main(int argc, char* argv[]) {
     specifyFixedVertices(fixedVerticesFile, options.fixedVertices);
   }
 
+  // interleave positions with attributes as in a vertex buffer; attributes
+  // are left zero
+  const size_t attributes = 5;
+  vector<double> records;
+  vector<float> recordsF;
+  vector<idx> flatIndices;
+  VertexBuffer buffer;
+  if (interleaved) {
+    buffer.count = positions.size();
+    buffer.doublePrecision = !singlePrecision;
+    buffer.stride = (3 + attributes) * (singlePrecision ? sizeof(float)
+                                                        : sizeof(double));
+    records.resize(singlePrecision ? 0 : buffer.count * (3 + attributes));
+    recordsF.resize(singlePrecision ? buffer.count * (3 + attributes) : 0);
+    for (size_t v = 0; v < positions.size(); ++v)
+      for (int i = 0; i < 3; ++i)
+        if (singlePrecision)
+          recordsF[v * (3 + attributes) + i] = positions[v][i];
+        else
+          records[v * (3 + attributes) + i] = positions[v][i];
+    buffer.data = singlePrecision ? static_cast<void*>(recordsF.data())
+                                  : static_cast<void*>(records.data());
+    for (const auto& face : indices)
+      flatIndices.insert(flatIndices.end(), face.begin(), face.end());
+    Positions().swap(positions);
+    Indices().swap(indices);
+  }
+
+  // round to float
+  PositionsF positionsF;
+  if (singlePrecision && !interleaved) {
+    for (const auto& pos : positions)
+      positionsF.push_back({static_cast<float>(pos[0]),
+                            static_cast<float>(pos[1]),
+                            static_cast<float>(pos[2])});
+    Positions().swap(positions);
+  }
+
   // simplify
+  vector<Mesh> lods;
+  CollapseLog log;
   const auto before = chrono::steady_clock::now();
-  simplify(positions, indices, options);
+  if (streamWindow > 0) {
+    ObjSink sink(out);
+    StreamSimplifier simplifier(sink, options, streamWindow);
+    streamObj(in, simplifier);
+    const auto after = chrono::steady_clock::now();
+    cout << "Simplification completed ("
+         << chrono::duration_cast<chrono::milliseconds>(after - before).count()
+         << " ms)" << endl;
+    cout << "Wrote mesh (#V = " << sink.nv << "; #F = " << sink.nf << ") to "
+         << out << endl;
+    return 0;
+  } else if (memoryBudgetMiB > 0) {
+    SoupFile soup(in);
+    simplifyOutOfCore(soup, positions, indices, outOfCore);
+  } else if (field.width > 0) {
+    simplifyHeightfield(field, positions, indices, options);
+  } else if (clusterResolution > 0) {
+    ClusterOptions clusterOptions;
+    clusterOptions.resolution = clusterResolution;
+    clusterOptions.threads = options.threads;
+    cluster(positions, indices, clusterOptions);
+  } else if (interleaved) {
+    if (indexBits == 16)
+      buffer.count = simplifyBuffer<uint16_t>(buffer, flatIndices, options)
+                         .vertices;
+    else if (indexBits == 64)
+      buffer.count = simplifyBuffer<uint64_t>(buffer, flatIndices, options)
+                         .vertices;
+    else
+      buffer.count = simplifyBuffer<uint32_t>(buffer, flatIndices, options)
+                         .vertices;
+  } else if (!lodStrengths.empty()) {
+    options.keepVertices = indexOnly;
+    const vector<LodTarget> targets(lodStrengths.begin(), lodStrengths.end());
+    lods = simplifyLods(positions, indices, targets, options);
+  } else if (indexOnly) {
+    if (singlePrecision)
+      indices = simplifyIndices(positionsF, indices, options);
+    else
+      indices = simplifyIndices(positions, indices, options);
+  } else if (twoPhase || repeat > 0) {
+    Simplifier simplifier(options);
+    const Positions inputPositions = positions;
+    const Indices inputIndices = indices;
+    for (unsigned run = 0; run < max(repeat, 1u); ++run) {
+      const auto start = chrono::steady_clock::now();
+      const size_t allocated = allocations;
+      const MeshSize size = simplifier.simplify(inputPositions, inputIndices);
+      positions.resize(size.vertices);
+      indices.resize(size.faces);
+      simplifier.write(positions.data(), indices.data());
+      if (repeat == 0) break;
+      const auto end = chrono::steady_clock::now();
+      cout << "Run " << run << ": "
+           << chrono::duration_cast<chrono::microseconds>(end - start).count()
+           << " us, " << allocations - allocated << " allocations" << endl;
+    }
+  } else if (arenaRuns > 0) {
+    const Positions inputPositions = positions;
+    const Indices inputIndices = indices;
+    MonotonicArena arena;
+    MemoryResource* const resources[] = {newDeleteResource(), &arena};
+    for (MemoryResource* resource : resources) {
+      options.memoryResource = resource;
+      long total = 0;
+      size_t allocated = 0, arenaBytes = 0;
+      for (unsigned run = 0; run < arenaRuns; ++run) {
+        positions = inputPositions;
+        indices = inputIndices;
+        const auto start = chrono::steady_clock::now();
+        const size_t before = allocations;
+        simplify(positions, indices, options);
+        allocated += allocations - before;
+        arenaBytes = max(arenaBytes, arena.allocated());
+        arena.release();
+        const auto end = chrono::steady_clock::now();
+        total +=
+            chrono::duration_cast<chrono::microseconds>(end - start).count();
+      }
+      cout << (resource == &arena ? "Arena" : "Heap") << ": "
+           << total / arenaRuns << " us, " << allocated / arenaRuns
+           << " allocations per run";
+      if (resource == &arena)
+        cout << ", " << (arenaBytes >> 20) << " MiB from the arena";
+      cout << endl;
+    }
+  } else if (progressive) {
+    options.collapseLog = &log;
+    simplify(positions, indices, options);
+  } else if (singlePrecision) {
+    simplify(positionsF, indices, options);
+  } else if (byComponent)
+    simplifyComponents(positions, indices, options, shareBudget);
+  else
+    simplify(positions, indices, options);
   const auto after = chrono::steady_clock::now();
   const long duration =
       chrono::duration_cast<chrono::milliseconds>(after - before).count();
   cout << "Simplification completed (" << duration << " ms)" << endl;
 
+  for (size_t l = 0; l < lods.size(); ++l) {
+    const size_t dot = out.rfind('.');
+    const string path = dot == string::npos
+                            ? out + "." + to_string(l)
+                            : out.substr(0, dot) + "." + to_string(l) +
+                                  out.substr(dot);
+    const Positions& lodPositions =
+        lods[l].positions.empty() ? positions : lods[l].positions;
+    write_to_obj(path, lodPositions, lods[l].indices);
+    cout << "Wrote level " << l << " (#V = " << lodPositions.size()
+         << "; #F = " << lods[l].indices.size() << ") to " << path << endl;
+  }
+  if (!lods.empty()) return 0;
+
+  if (progressive) {
+    const string path = out.substr(0, out.rfind('.')) + ".log";
+    ofstream ofs(path, ios::binary);
+    log.write(ofs);
+    cout << "Wrote " << log.splits.size() << " splits (" << log.bytes()
+         << " bytes) to " << path << endl;
+
+    ProgressiveMesh mesh(positions, indices, log);
+    const auto start = chrono::steady_clock::now();
+    mesh.refine(mesh.levels());
+    const auto refined = chrono::steady_clock::now();
+    mesh.coarsen(mesh.levels());
+    const auto end = chrono::steady_clock::now();
+    const auto rate = [&](chrono::steady_clock::duration time) {
+      return static_cast<long>(log.splits.size() /
+                               chrono::duration<double>(time).count());
+    };
+    cout << "Refined to " << log.baseFaces + log.faces.size() << " faces at "
+         << rate(refined - start) << " splits/s, coarsened back at "
+         << rate(end - refined) << " collapses/s" << endl;
+  }
+
+  for (const auto& pos : positionsF)
+    positions.push_back({pos[0], pos[1], pos[2]});
+  for (size_t v = 0; interleaved && v < buffer.count; ++v) {
+    const size_t r = v * (3 + attributes);
+    if (singlePrecision)
+      positions.push_back({recordsF[r], recordsF[r + 1], recordsF[r + 2]});
+    else
+      positions.push_back({records[r], records[r + 1], records[r + 2]});
+  }
+  for (size_t f = 0; f < flatIndices.size(); f += 3)
+    indices.push_back(
+        {flatIndices[f], flatIndices[f + 1], flatIndices[f + 2]});
+
   // write to obj file
   write_to_obj(out, positions, indices);
   cout << "Wrote mesh (#V = " << positions.size() << "; #F = " << indices.size()
@@ -88,88 +444,38 @@ int main(int argc, char* argv[]) {
   return 0;
 }
 
-void load_obj(const string& filename, vector<vec3d>& positions,
-              vector<vec3i>& indices) {
+void specifyFixedVertices(const string& filename, vector<bool>& fixed) {
+  vector<int> vids;
   ifstream ifs(filename);
+  copy(istream_iterator<int>(ifs), istream_iterator<int>(),
+       back_inserter(vids));
+  ifs.close();
+  for_each(vids.begin(), vids.end(), [&fixed](int v) { fixed[v - 1] = true; });
+}
 
-  positions.resize(0);
-  indices.resize(0);
-
-  string lead;
+void streamObj(const string& filename, StreamSimplifier& simplifier) {
+  ifstream ifs(filename);
   for (string line; getline(ifs, line);) {
-    if (line[0] == '#') continue;
-
-    lead = "";
-    stringstream ss(line);
+    istringstream ss(line);
+    string lead;
     ss >> lead;
-
     if (lead == "v") {
-      double x, y, z;
-      ss >> x >> y >> z;
-      positions.push_back({x, y, z});
+      vec3d position;
+      ss >> position[0] >> position[1] >> position[2];
+      simplifier.addVertex(position);
     } else if (lead == "f") {
       vec3i face;
-      for (int i = 0; i < 3; ++i) {
-        ss >> face[i];
-        char ch;
-        do {
-          ch = ss.get();
-        } while (!ss.eof() && ch != ' ');
+      for (auto& v : face) {
+        ss >> v;
+        ss.ignore(numeric_limits<streamsize>::max(), ' ');
+        --v;
       }
-      for (int i = 0; i < 3; ++i) --face[i];
-      indices.push_back(face);
+      simplifier.addFace(face);
+    } else if (lead == "x") {
+      idx v;
+      ss >> v;
+      simplifier.finalize(v - 1);
     }
   }
-
-  ifs.close();
-}
-
-void write_to_obj(const string& filename, const vector<vec3d>& positions,
-                  const vector<vec3i>& indices) {
-  ofstream ofs(filename);
-
-  const int precision = 9;
-
-  int coord_col_len = precision + 4;
-  double coord = 0.0;
-  for (const auto& v : positions)
-    coord = max({coord, abs(v[0]), abs(v[1]), abs(v[2])});
-  for (unsigned sz = floor(coord); sz > 0; sz /= 10, ++coord_col_len)
-    ;
-
-  int v_col_len = 1;
-  for (unsigned sz = positions.size(); sz > 0; sz /= 10, ++v_col_len)
-    ;
-
-  ofs << "#" << endl
-      << "# plain triangle mesh" << endl
-      << "# vertex count: " << positions.size() << endl
-      << "# face count:   " << indices.size() << endl
-      << "#" << endl
-      << endl;
-
-  ofs << fixed << setprecision(precision);
-  for (const auto& v : positions) {
-    ofs << "v";
-    for (const double x : v) ofs << right << setw(coord_col_len) << x;
-    ofs << endl;
-  }
-  ofs << endl;
-  for (const auto& f : indices) {
-    ofs << "f";
-    for (const auto v : f) ofs << right << setw(v_col_len) << v + 1;
-    ofs << endl;
-  }
-  ofs << endl;
-
-  ofs.close();
-}
-
-void specifyFixedVertices(const string& filename, vector<bool>& fixed) {
-  vector<int> vids;
-  ifstream ifs(filename);
-  copy(istream_iterator<int>(ifs), istream_iterator<int>(),
-       back_inserter(vids));
-  ifs.close();
-  for_each(vids.begin(), vids.end(), [&fixed](int v) { fixed[v - 1] = true; });
+  simplifier.finish();
 }
@@ -0,0 +1,95 @@
+#ifndef MESH_SIMPL_EXAMPLE_OBJ_HPP
+#define MESH_SIMPL_EXAMPLE_OBJ_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <types.hpp>
+#include <vector>
+
+// Reading and writing of plain triangle meshes in .obj format, shared by the
+// executables
+
+inline void load_obj(const std::string& filename,
+                     std::vector<MeshSimpl::vec3d>& positions,
+                     std::vector<MeshSimpl::vec3i>& indices) {
+  std::ifstream ifs(filename);
+
+  positions.resize(0);
+  indices.resize(0);
+
+  std::string lead;
+  for (std::string line; std::getline(ifs, line);) {
+    if (line[0] == '#') continue;
+
+    lead = "";
+    std::stringstream ss(line);
+    ss >> lead;
+
+    if (lead == "v") {
+      double x, y, z;
+      ss >> x >> y >> z;
+      positions.push_back({x, y, z});
+    } else if (lead == "f") {
+      MeshSimpl::vec3i face;
+      for (int i = 0; i < 3; ++i) {
+        ss >> face[i];
+        char ch;
+        do {
+          ch = ss.get();
+        } while (!ss.eof() && ch != ' ');
+      }
+      for (int i = 0; i < 3; ++i) --face[i];
+      indices.push_back(face);
+    }
+  }
+
+  ifs.close();
+}
+
+inline void write_to_obj(const std::string& filename,
+                         const std::vector<MeshSimpl::vec3d>& positions,
+                         const std::vector<MeshSimpl::vec3i>& indices) {
+  std::ofstream ofs(filename);
+
+  const int precision = 9;
+
+  int coord_col_len = precision + 4;
+  double coord = 0.0;
+  for (const auto& v : positions)
+    coord = std::max({coord, std::abs(v[0]), std::abs(v[1]), std::abs(v[2])});
+  for (unsigned sz = std::floor(coord); sz > 0; sz /= 10, ++coord_col_len)
+    ;
+
+  int v_col_len = 1;
+  for (unsigned sz = positions.size(); sz > 0; sz /= 10, ++v_col_len)
+    ;
+
+  ofs << "#" << std::endl
+      << "# plain triangle mesh" << std::endl
+      << "# vertex count: " << positions.size() << std::endl
+      << "# face count:   " << indices.size() << std::endl
+      << "#" << std::endl
+      << std::endl;
+
+  ofs << std::fixed << std::setprecision(precision);
+  for (const auto& v : positions) {
+    ofs << "v";
+    for (const double x : v) ofs << std::right << std::setw(coord_col_len) << x;
+    ofs << std::endl;
+  }
+  ofs << std::endl;
+  for (const auto& f : indices) {
+    ofs << "f";
+    for (const auto v : f) ofs << std::right << std::setw(v_col_len) << v + 1;
+    ofs << std::endl;
+  }
+  ofs << std::endl;
+
+  ofs.close();
+}
+
+#endif  // MESH_SIMPL_EXAMPLE_OBJ_HPP
@@ -0,0 +1,135 @@
+#include "bucketqueue.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace MeshSimpl {
+namespace Internal {
+
+const idx BucketQueue::NONE;
+
+// bits of the exponent and the sign of a double
+static const unsigned EXPONENT_BITS = 12;
+
+// the bits of +infinity; the bits of positive doubles are ordered as the
+// doubles
+static const uint64_t INFINITY_BITS = 0x7ff0000000000000ull;
+
+BucketQueue::BucketQueue(Edges &edges, unsigned bits)
+    : edges(edges),
+      shift(64 - EXPONENT_BITS - bits),
+      heads((INFINITY_BITS >> shift) + 1),
+      words((heads.size() + 63) / 64),
+      summary((words.size() + 63) / 64) {
+  reset();
+}
+
+void BucketQueue::reset() {
+  // heads of empty buckets are not read, so only words left from the mesh
+  // before are cleared, found through the summary, instead of the millions
+  // of heads
+  for (size_t s = 0; s < summary.size(); ++s)
+    for (uint64_t bits = summary[s]; bits != 0; bits &= bits - 1)
+      words[s * 64 + __builtin_ctzll(bits)] = 0;
+  std::fill(summary.begin(), summary.end(), 0);
+  next.assign(edges.size(), NONE);
+  prev.assign(edges.size(), NONE);
+  buckets.assign(edges.size(), NONE);
+  removed.assign(edges.size(), false);
+  linked = 0;
+  least = 0;
+}
+
+void BucketQueue::prioritize() {
+  for (idx e = 0; e < edges.size(); ++e)
+    if (!removed[e]) link(e);
+}
+
+Edge *BucketQueue::top() {
+  if (empty()) return nullptr;
+
+  // the first bit set at or after `least`, in its word or the next word that
+  // is not zero
+  size_t w = least / 64;
+  uint64_t word = words[w] & (~0ull << least % 64);
+  if (word == 0) {
+    size_t s = (w + 1) / 64;
+    uint64_t bits = (w + 1) % 64 == 0 ? summary[s]
+                                      : summary[s] & (~0ull << (w + 1) % 64);
+    while (bits == 0) bits = summary[++s];
+    w = s * 64 + __builtin_ctzll(bits);
+    word = words[w];
+  }
+  least = w * 64 + __builtin_ctzll(word);
+  return &edges[heads[least]];
+}
+
+void BucketQueue::pop() {
+  if (!empty()) unlink(id(top()));
+}
+
+void BucketQueue::fix(const Edge *edge, double) {
+  const idx e = id(edge);
+  assert(contains(edge));
+  if (buckets[e] == bucket(edge->error())) return;
+  unlink(e);
+  link(e);
+}
+
+void BucketQueue::penalize(Edge *edge) {
+  edge->setErrorInfty();
+  const idx e = id(edge);
+  unlink(e);
+  link(e);
+}
+
+void BucketQueue::markRemoved(const Edge *edge) {
+  const idx e = id(edge);
+  removed[e] = true;
+  unlink(e);
+}
+
+idx BucketQueue::bucket(double error) const {
+  if (error == std::numeric_limits<double>::max()) return heads.size() - 1;
+  // zero, and negative errors of rounding, go to the first bucket
+  if (!(error > 0)) return 0;
+  uint64_t bits;
+  std::memcpy(&bits, &error, sizeof(bits));
+  return bits >> shift;
+}
+
+void BucketQueue::link(idx e) {
+  const idx b = bucket(edges[e].error());
+  const bool occupied = words[b / 64] >> b % 64 & 1;
+  buckets[e] = b;
+  prev[e] = NONE;
+  next[e] = occupied ? heads[b] : NONE;
+  if (occupied) prev[heads[b]] = e;
+  heads[b] = e;
+
+  words[b / 64] |= 1ull << b % 64;
+  summary[b / 4096] |= 1ull << b / 64 % 64;
+  if (b < least) least = b;
+  ++linked;
+}
+
+void BucketQueue::unlink(idx e) {
+  const idx b = buckets[e];
+  if (b == NONE) return;
+  if (prev[e] != NONE)
+    next[prev[e]] = next[e];
+  else
+    heads[b] = next[e];
+  if (next[e] != NONE) prev[next[e]] = prev[e];
+  buckets[e] = NONE;
+
+  if (heads[b] == NONE) {
+    words[b / 64] &= ~(1ull << b % 64);
+    if (words[b / 64] == 0) summary[b / 4096] &= ~(1ull << b / 64 % 64);
+  }
+  --linked;
+}
+
+}  // namespace Internal
+}  // namespace MeshSimpl
@@ -0,0 +1,75 @@
+#ifndef MESH_SIMPL_BUCKETQUEUE_HPP
+#define MESH_SIMPL_BUCKETQUEUE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "edge.hpp"
+#include "edgequeue.hpp"
+#include "types.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+// Edges in buckets of errors sharing the exponent and the leading `bits` bits
+// of the mantissa, i.e., within a relative band of 2^-bits of each other. The
+// next edge is one of the least bucket, the one fixed last, so collapses are
+// only ordered up to the band; in return updates take constant time instead
+// of logarithmic, and the least bucket is found through a bitmap of buckets
+// that are not empty and a bitmap of its words
+class BucketQueue final : public EdgeQueue {
+ public:
+  BucketQueue(Edges &edges, unsigned bits);
+
+  void reset() override;
+
+  void prioritize() override;
+
+  Edge *top() override;
+
+  void pop() override;
+
+  void fix(const Edge *edge, double errorPrev) override;
+
+  void penalize(Edge *edge) override;
+
+  bool empty() const override { return linked == 0; }
+
+  bool contains(const Edge *edge) const override {
+    return !removed[id(edge)];
+  }
+
+  void markRemoved(const Edge *edge) override;
+  void unmarkRemoved(const Edge *edge) override {
+    removed[id(edge)] = false;
+  }
+
+ private:
+  static const idx NONE = std::numeric_limits<idx>::max();
+
+  Edges &edges;
+  const unsigned shift;     // bits of a double dropped from its bucket
+  Array<idx> heads;         // first edge in each bucket that is not empty
+  Array<idx> next, prev;    // edges in the same bucket
+  Array<idx> buckets;       // buckets[e] is the bucket of e or NONE
+  Array<uint64_t> words;    // a bit per bucket, set if not empty
+  Array<uint64_t> summary;  // a bit per word, set if not zero
+  Array<bool> removed;      // erased from queue
+  size_t linked = 0;        // edges in buckets
+  size_t least = 0;         // buckets below are empty
+
+  idx id(const Edge *edge) const { return edge - edges.data(); }
+
+  // Bucket of an error; penalized edges get the last one
+  idx bucket(double error) const;
+
+  // Put an edge into the bucket of its error or take it out of its bucket
+  void link(idx e);
+  void unlink(idx e);
+};
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_BUCKETQUEUE_HPP
@@ -0,0 +1,509 @@
+#include "cluster.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "components.hpp"
+#include "parallel.hpp"
+#include "proc.hpp"
+#include "simplify.hpp"
+#include "util.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+// cell coordinates are packed into 21 bits each
+static const unsigned MAX_RESOLUTION = (1u << 21) - 1;
+
+// faces accumulated into one partial map; fixed so that sums are added in the
+// same order whatever the number of threads
+static const size_t FACE_BLOCK = 1 << 16;
+
+// resolution of the first grid tried by clusterToFaceCount() and the number
+// of grids tried at most
+static const unsigned PROBE_RESOLUTION = 32;
+static const int PROBES = 4;
+
+// estimated bytes taken by a cell, including its key, its node in the index
+// of CellList and the slack of growing vectors, and by an output face of
+// clusterOutOfCore(), including its node in the set of faces seen; a cell is
+// expected to bring two faces
+static const size_t CELL_BYTES = 2 * sizeof(Cell) + sizeof(uint64_t) + 48;
+static const size_t FACE_BYTES = 2 * sizeof(vec3i) + 64;
+static const size_t FACES_PER_CELL = 2;
+
+Grid::Grid(const vec3d& lo, const vec3d& hi, unsigned resolution)
+    : _lo(lo), _resolution(resolution) {
+  double extent = 0;
+  for (int i = 0; i < 3; ++i) extent = std::max(extent, hi[i] - lo[i]);
+  _size = extent > 0 ? extent / resolution : 1;
+}
+
+uint64_t Grid::cell(const vec3d& pos) const {
+  uint64_t key = 0;
+  for (int i = 0; i < 3; ++i) {
+    // positions on the far side of the box belong to the last cell
+    const double c = std::floor((pos[i] - _lo[i]) / _size);
+    const uint64_t coord =
+        std::min(std::max(c, 0.0), static_cast<double>(_resolution - 1));
+    key |= coord << (21 * i);
+  }
+  return key;
+}
+
+uint64_t Grid::parent(uint64_t key) {
+  uint64_t parentKey = 0;
+  for (int i = 0; i < 3; ++i)
+    parentKey |= (key >> (21 * i) & MAX_RESOLUTION) >> 1 << (21 * i);
+  return parentKey;
+}
+
+Grid Grid::coarser() const {
+  // halving a cell coordinate is exact, so positions fall into the parent of
+  // their cell
+  Grid grid = *this;
+  grid._size *= 2;
+  grid._resolution = (_resolution + 1) / 2;
+  return grid;
+}
+
+vec3d Grid::cellLo(uint64_t key) const {
+  vec3d lo;
+  for (int i = 0; i < 3; ++i)
+    lo[i] = _lo[i] + static_cast<double>(key >> (21 * i) & MAX_RESOLUTION) *
+                         _size;
+  return lo;
+}
+
+vec3d Grid::cellHi(uint64_t key) const {
+  vec3d hi = cellLo(key);
+  for (auto& x : hi) x += _size;
+  return hi;
+}
+
+bool faceQuadric(const vec3d& p0, const vec3d& p1, const vec3d& p2,
+                 bool weightByArea, Quadric& q) {
+  // same plane as computeQuadrics() derives from the edges of a face
+  vec3d normal = cross(p0 - p1, p2 - p0);
+  const double area = magnitude(normal);
+  if (area == 0) return false;
+  normal /= area;
+
+  q = Quadric(normal, -dot(normal, p0));
+  if (weightByArea) q *= area;
+  return true;
+}
+
+vec3d representative(const Cell& cell, const vec3d& lo, const vec3d& hi) {
+  const double aDet = cell.q.aDeterminant();
+  if (aDet != 0) {
+    const vec3d pos = cell.q.optimal(aDet).first;
+    // written so that NaN fails the test
+    if (pos[0] >= lo[0] && pos[0] <= hi[0] && pos[1] >= lo[1] &&
+        pos[1] <= hi[1] && pos[2] >= lo[2] && pos[2] <= hi[2])
+      return pos;
+  }
+  return {cell.sum[0] / cell.count, cell.sum[1] / cell.count,
+          cell.sum[2] / cell.count};
+}
+
+namespace {
+
+// Cells touched by some faces, in order of first touch
+struct CellList {
+  std::vector<uint64_t> keys;
+  std::vector<Cell> cells;
+  std::unordered_map<uint64_t, idx> index;  // key -> position in lists
+
+  Cell& operator[](uint64_t key) {
+    const auto it = index.emplace(key, keys.size());
+    if (it.second) {
+      keys.push_back(key);
+      cells.emplace_back();
+    }
+    return cells[it.first->second];
+  }
+};
+
+struct FaceHash {
+  size_t operator()(const vec3i& face) const {
+    const std::hash<uint64_t> hash;
+    return hash((static_cast<uint64_t>(face[0]) << 32 | face[1]) ^
+                static_cast<uint64_t>(face[2]) * 0x9e3779b97f4a7c15ull);
+  }
+};
+
+}  // namespace
+
+static bool isDegenerate(const vec3i& face) {
+  return face[0] == face[1] || face[1] == face[2] || face[2] == face[0];
+}
+
+// Corners of a face in increasing order, the same for all its orientations
+static vec3i sortedFace(vec3i face) {
+  std::sort(face.begin(), face.end());
+  return face;
+}
+
+// Number the cells referenced by faces given on cells, in order of cell
+// creation, and write them as output vertices at their representatives
+static void emitClusters(const Grid& grid, const CellList& cells,
+                         Indices& clustered, ThreadPool& pool,
+                         Positions& outPositions, Indices& outIndices,
+                         std::vector<Quadric>* quadrics) {
+  std::vector<idx> remap(cells.keys.size(), 0);
+  for (const auto& face : clustered)
+    for (idx c : face) remap[c] = 1;
+
+  std::vector<idx> used;  // cells of output vertices
+  for (idx c = 0; c < remap.size(); ++c) {
+    if (!remap[c]) continue;
+    remap[c] = used.size();
+    used.push_back(c);
+  }
+  const idx nv = used.size();
+  for (auto& face : clustered)
+    for (auto& c : face) c = remap[c];
+
+  outPositions.resize(nv);
+  pool.parallelFor(nv, FACE_BLOCK, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+      const uint64_t key = cells.keys[used[v]];
+      outPositions[v] = representative(cells.cells[used[v]], grid.cellLo(key),
+                                    grid.cellHi(key));
+    }
+  });
+  outIndices.swap(clustered);
+
+  if (quadrics) {
+    quadrics->resize(nv);
+    for (idx v = 0; v < nv; ++v) (*quadrics)[v] = cells.cells[used[v]].q;
+  }
+}
+
+void clusterMesh(const Positions& positions, const Indices& indices,
+                 const ClusterOptions& options, Positions& outPositions,
+                 Indices& outIndices, std::vector<Quadric>* quadrics) {
+  ThreadPool pool(options.threads);
+  const size_t blocks = (indices.size() + FACE_BLOCK - 1) / FACE_BLOCK;
+  const auto faceRange = [&](size_t b) {
+    return std::make_pair(b * FACE_BLOCK,
+                          std::min(indices.size(), (b + 1) * FACE_BLOCK));
+  };
+
+  // bounding box
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<vec3d> los(pool.size(), {inf, inf, inf});
+  std::vector<vec3d> his(pool.size(), {-inf, -inf, -inf});
+  pool.runOnAll([&](unsigned t) {
+    const auto range = pool.block(positions.size(), t);
+    for (size_t v = range.first; v < range.second; ++v) {
+      for (int i = 0; i < 3; ++i) {
+        los[t][i] = std::min(los[t][i], positions[v][i]);
+        his[t][i] = std::max(his[t][i], positions[v][i]);
+      }
+    }
+  });
+  vec3d lo = los[0], hi = his[0];
+  for (unsigned t = 1; t < pool.size(); ++t) {
+    for (int i = 0; i < 3; ++i) {
+      lo[i] = std::min(lo[i], los[t][i]);
+      hi[i] = std::max(hi[i], his[t][i]);
+    }
+  }
+  const Grid grid(lo, hi, options.resolution);
+
+  // first pass: sum face quadrics and corner positions into the cells of the
+  // corners, block by block, then merge the blocks in order
+  CellList cells;
+  std::vector<CellList> partial(pool.size());
+  for (size_t b0 = 0; b0 < blocks; b0 += pool.size()) {
+    const size_t wave = std::min<size_t>(pool.size(), blocks - b0);
+    pool.parallelFor(wave, 1, [&](size_t begin, size_t end) {
+      for (size_t w = begin; w < end; ++w) {
+        CellList& list = partial[w];
+        const auto range = faceRange(b0 + w);
+        for (size_t f = range.first; f < range.second; ++f) {
+          const vec3i& face = indices[f];
+          Quadric q;
+          const bool planar =
+              faceQuadric(positions[face[0]], positions[face[1]],
+                          positions[face[2]], options.weightByArea, q);
+          for (order k = 0; k < 3; ++k) {
+            const vec3d& pos = positions[face[k]];
+            Cell& cell = list[grid.cell(pos)];
+            if (planar) cell.q += q;
+            for (int i = 0; i < 3; ++i) cell.sum[i] += pos[i];
+            cell.count += 1;
+          }
+        }
+      }
+    });
+    for (size_t w = 0; w < wave; ++w) {
+      for (size_t c = 0; c < partial[w].keys.size(); ++c)
+        cells[partial[w].keys[c]] += partial[w].cells[c];
+      partial[w] = CellList();
+    }
+  }
+
+  // second pass: map corners to cells and drop faces that collapsed
+  std::vector<Indices> blockFaces(blocks);
+  pool.parallelFor(blocks, 1, [&](size_t begin, size_t end) {
+    for (size_t b = begin; b < end; ++b) {
+      const auto range = faceRange(b);
+      for (size_t f = range.first; f < range.second; ++f) {
+        vec3i face;
+        for (order k = 0; k < 3; ++k)
+          face[k] = cells.index.find(grid.cell(positions[indices[f][k]]))
+                        ->second;
+        if (!isDegenerate(face)) blockFaces[b].push_back(face);
+      }
+    }
+  });
+
+  // keep the first of faces on the same cells, whatever their orientation
+  Indices clustered;
+  std::unordered_set<vec3i, FaceHash> seen;
+  for (auto& faces : blockFaces) {
+    for (const auto& face : faces)
+      if (seen.insert(sortedFace(face)).second) clustered.push_back(face);
+    Indices().swap(faces);
+  }
+  std::unordered_set<vec3i, FaceHash>().swap(seen);
+
+  emitClusters(grid, cells, clustered, pool, outPositions, outIndices,
+               quadrics);
+}
+
+void clusterOutOfCore(TriangleSource& source, const OutOfCoreOptions& options,
+                      size_t faceBytes, Positions& outPositions,
+                      Indices& outIndices, std::vector<Quadric>& quadrics) {
+  if (options.resolution == 0 || options.resolution > MAX_RESOLUTION)
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: resolution not between 1 and 2097151");
+  if (options.memoryBudget == 0)
+    throw std::invalid_argument("ERROR::INVALID_OPTION: memory budget is 0");
+  const size_t budget = options.memoryBudget;
+  faceBytes += FACE_BYTES;
+  std::array<vec3d, 3> corners;
+
+  // first pass: bounding box
+  const double inf = std::numeric_limits<double>::infinity();
+  vec3d lo = {inf, inf, inf}, hi = {-inf, -inf, -inf};
+  source.rewind();
+  while (source.next(corners)) {
+    for (const auto& pos : corners) {
+      for (int i = 0; i < 3; ++i) {
+        lo[i] = std::min(lo[i], pos[i]);
+        hi[i] = std::max(hi[i], pos[i]);
+      }
+    }
+  }
+  if (lo[0] > hi[0]) {
+    outPositions.clear();
+    outIndices.clear();
+    quadrics.clear();
+    return;
+  }
+  Grid grid(lo, hi, options.resolution);
+
+  // merge cells into those of the coarser grid; faces are remapped, and those
+  // that collapsed or became duplicates dropped
+  CellList cells;
+  Indices clustered;
+  std::unordered_set<vec3i, FaceHash> seen;
+  const auto coarsen = [&]() {
+    CellList merged;
+    std::vector<idx> remap(cells.keys.size());
+    for (idx c = 0; c < cells.keys.size(); ++c) {
+      const uint64_t key = Grid::parent(cells.keys[c]);
+      merged[key] += cells.cells[c];
+      remap[c] = merged.index[key];
+    }
+    grid = grid.coarser();
+    cells = std::move(merged);
+
+    seen.clear();
+    size_t nf = 0;
+    for (const auto& face : clustered) {
+      const vec3i mapped = {remap[face[0]], remap[face[1]], remap[face[2]]};
+      if (isDegenerate(mapped) || !seen.insert(sortedFace(mapped)).second)
+        continue;
+      clustered[nf++] = mapped;
+    }
+    clustered.resize(nf);
+  };
+
+  // second pass: sum face quadrics and corner positions into cells, leaving
+  // room for the faces expected
+  source.rewind();
+  while (source.next(corners)) {
+    Quadric q;
+    const bool planar = faceQuadric(corners[0], corners[1], corners[2],
+                                    options.weightByArea, q);
+    for (const auto& pos : corners) {
+      Cell& cell = cells[grid.cell(pos)];
+      if (planar) cell.q += q;
+      for (int i = 0; i < 3; ++i) cell.sum[i] += pos[i];
+      cell.count += 1;
+    }
+    while (cells.keys.size() * (CELL_BYTES + FACES_PER_CELL * faceBytes) >
+               budget &&
+           grid.resolution() > 1)
+      coarsen();
+  }
+
+  // third pass: map corners to cells and keep the first of faces on the same
+  // cells, coarsening further if the faces do not fit
+  source.rewind();
+  while (source.next(corners)) {
+    vec3i face;
+    for (order k = 0; k < 3; ++k) {
+      const auto it = cells.index.find(grid.cell(corners[k]));
+      if (it == cells.index.end())
+        throw std::runtime_error(
+            "ERROR::INPUT_MESH: triangle source changed between reads");
+      face[k] = it->second;
+    }
+    if (isDegenerate(face) || !seen.insert(sortedFace(face)).second) continue;
+    clustered.push_back(face);
+    while (cells.keys.size() * CELL_BYTES + clustered.size() * faceBytes >
+               budget &&
+           grid.resolution() > 1)
+      coarsen();
+  }
+  std::unordered_set<vec3i, FaceHash>().swap(seen);
+
+  ThreadPool serial(1);
+  emitClusters(grid, cells, clustered, serial, outPositions, outIndices,
+               &quadrics);
+}
+
+// Duplicate vertices whose faces form several fans, i.e., groups of faces
+// connected through manifold edges of the vertex, one copy per extra fan
+static void splitFans(Positions& positions, Indices& indices,
+                      std::vector<Quadric>& quadrics) {
+  UnionFind fans(indices.size() * 3);
+  const auto corner = [&](idx f, idx v) -> idx {
+    const auto& face = indices[f];
+    return f * 3 + static_cast<idx>(std::find(face.begin(), face.end(), v) -
+                                    face.begin());
+  };
+  const auto sides = sortedHalfEdges(indices);
+  for (size_t i = 0, j; i < sides.size(); i = j) {
+    for (j = i + 1; j < sides.size() && sides[j].key == sides[i].key; ++j)
+      ;
+    if (j - i != 2) continue;
+    for (const idx v : {sides[i].v0(), sides[i].v1()})
+      fans.unite(corner(sides[i].f, v), corner(sides[i + 1].f, v));
+  }
+
+  // the first fan of a vertex keeps it, others get a copy. the root of a fan
+  // is its first corner, so it is visited before the rest of the fan
+  std::vector<idx> fanVertex(indices.size() * 3);
+  std::vector<char> taken(positions.size(), 0);
+  for (idx c = 0; c < fanVertex.size(); ++c) {
+    idx& v = indices[c / 3][c % 3];
+    const idx root = fans.find(c);
+    if (root == c) {
+      if (taken[v]) {
+        positions.push_back(positions[v]);
+        quadrics.push_back(quadrics[v]);
+        fanVertex[c] = positions.size() - 1;
+      } else {
+        taken[v] = 1;
+        fanVertex[c] = v;
+      }
+    }
+    v = fanVertex[root];
+  }
+}
+
+void makeManifold(Positions& positions, Indices& indices,
+                  std::vector<Quadric>& quadrics) {
+  // cutting along edges with more than two faces separates most of them
+  splitFans(positions, indices, quadrics);
+
+  // drop faces beyond the first two on the edges left, which may pinch
+  // vertices again
+  const auto sides = sortedHalfEdges(indices);
+  std::vector<char> dropped(indices.size(), 0);
+  for (size_t i = 2; i < sides.size(); ++i)
+    if (sides[i].key == sides[i - 2].key) dropped[sides[i].f] = 1;
+  size_t nf = 0;
+  for (idx f = 0; f < indices.size(); ++f)
+    if (!dropped[f]) indices[nf++] = indices[f];
+  if (nf == indices.size()) return;
+  indices.resize(nf);
+  splitFans(positions, indices, quadrics);
+}
+
+bool clusterToFaceCount(Positions& positions, Indices& indices, size_t faces,
+                        size_t minFaces, const SimplifyOptions& options,
+                        std::vector<Quadric>& quadrics) {
+  ClusterOptions clusterOptions;
+  clusterOptions.weightByArea = options.weightByArea;
+  clusterOptions.threads = options.threads;
+
+  // the face count grows about with the square of the resolution; probe
+  // coarse grids, which are cheap, and scale the resolution accordingly
+  Positions clusteredPositions;
+  Indices clusteredIndices;
+  std::vector<Quadric> clusteredQuadrics;
+  unsigned resolution = PROBE_RESOLUTION;
+  for (int probe = 0; probe < PROBES; ++probe) {
+    clusterOptions.resolution = resolution;
+    clusterMesh(positions, indices, clusterOptions, clusteredPositions,
+                clusteredIndices, &clusteredQuadrics);
+
+    const double ratio = static_cast<double>(faces) /
+                         std::max<size_t>(clusteredIndices.size(), 1);
+    if (clusteredIndices.size() >= minFaces && ratio > 2.0 / 3 &&
+        ratio < 3.0 / 2)
+      break;
+    const unsigned scaled = static_cast<unsigned>(std::min<double>(
+        std::max(std::lround(resolution * std::sqrt(ratio)), 1l),
+        MAX_RESOLUTION));
+    if (scaled == resolution) break;
+    resolution = scaled;
+  }
+  if (clusteredIndices.size() < minFaces) return false;
+
+  makeManifold(clusteredPositions, clusteredIndices, clusteredQuadrics);
+  if (clusteredIndices.size() < minFaces) return false;
+
+  positions.swap(clusteredPositions);
+  indices.swap(clusteredIndices);
+  quadrics.swap(clusteredQuadrics);
+  return true;
+}
+
+}  // namespace Internal
+
+void cluster(Positions& positions, Indices& indices,
+             const ClusterOptions& options) {
+  if (options.resolution == 0 || options.resolution > Internal::MAX_RESOLUTION)
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: resolution not between 1 and 2097151");
+  for (const auto& face : indices)
+    for (idx v : face)
+      if (v >= positions.size())
+        throw std::invalid_argument(
+            "ERROR::INPUT_MESH: face refers to a missing vertex");
+
+  Positions clusteredPositions;
+  Indices clusteredIndices;
+  Internal::clusterMesh(positions, indices, options, clusteredPositions,
+                        clusteredIndices);
+  positions.swap(clusteredPositions);
+  indices.swap(clusteredIndices);
+}
+
+}  // namespace MeshSimpl
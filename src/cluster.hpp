@@ -0,0 +1,98 @@
+#ifndef MESH_SIMPL_CLUSTER_HPP
+#define MESH_SIMPL_CLUSTER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "quadric.hpp"
+#include "types.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+// Uniform grid of cubic cells over a bounding box; `resolution` cells along
+// its longest side
+class Grid {
+ public:
+  Grid(const vec3d& lo, const vec3d& hi, unsigned resolution);
+
+  // Key of the cell containing a position
+  uint64_t cell(const vec3d& pos) const;
+
+  // Key of the cell containing cell `key` in the coarser() grid
+  static uint64_t parent(uint64_t key);
+
+  // Grid of cells twice as large, with the same origin
+  Grid coarser() const;
+
+  // Corners of a cell
+  vec3d cellLo(uint64_t key) const;
+  vec3d cellHi(uint64_t key) const;
+
+  unsigned resolution() const { return _resolution; }
+
+ private:
+  vec3d _lo;
+  double _size;  // edge length of a cell
+  unsigned _resolution;
+};
+
+// What is known about the vertices falling into one cell
+struct Cell {
+  Quadric q{};     // sum of quadrics of faces incident to these vertices
+  vec3d sum = {};  // sum of positions
+  double count = 0;
+
+  Cell& operator+=(const Cell& c) {
+    q += c.q;
+    for (int i = 0; i < 3; ++i) sum[i] += c.sum[i];
+    count += c.count;
+    return *this;
+  }
+};
+
+// Quadric of the plane of a face, scaled by its area if weightByArea; false
+// if the face is degenerate
+bool faceQuadric(const vec3d& p0, const vec3d& p1, const vec3d& p2,
+                 bool weightByArea, Quadric& q);
+
+// Position representing a cell: the minimizer of its quadric if that lies in
+// the cell, otherwise the mean of its vertices
+vec3d representative(const Cell& cell, const vec3d& lo, const vec3d& hi);
+
+// Vertex clustering of a mesh on a grid; faces whose corners fall into fewer
+// than three cells and duplicated faces are dropped. If `quadrics` is given,
+// it receives the summed quadric of every output vertex
+void clusterMesh(const Positions& positions, const Indices& indices,
+                 const ClusterOptions& options, Positions& outPositions,
+                 Indices& outIndices,
+                 std::vector<Quadric>* quadrics = nullptr);
+
+// Vertex clustering of triangle soup as by clusterMesh(), reading `source`
+// three times: for the bounding box, the cells and the faces. Whenever the
+// cells and output faces would take more than options.memoryBudget bytes, each
+// face also counting `faceBytes`, the grid is replaced by its coarser() one.
+// `quadrics` receives the summed quadric of every output vertex
+void clusterOutOfCore(TriangleSource& source, const OutOfCoreOptions& options,
+                      size_t faceBytes, Positions& outPositions,
+                      Indices& outIndices, std::vector<Quadric>& quadrics);
+
+// Turn a clustered mesh into a 2-manifold that buildConnectivity() accepts:
+// faces beyond the first two on an edge are dropped, then vertices whose faces
+// form several fans are duplicated, one copy per fan. Duplicates are appended
+// and copy the quadric of their original
+void makeManifold(Positions& positions, Indices& indices,
+                  std::vector<Quadric>& quadrics);
+
+// Cluster a mesh to about `faces` faces, searching for the grid resolution,
+// and make it manifold; `quadrics` receives the quadrics of the vertices.
+// Returns false and leaves the mesh untouched if no resolution gives at least
+// `minFaces` faces
+bool clusterToFaceCount(Positions& positions, Indices& indices, size_t faces,
+                        size_t minFaces, const SimplifyOptions& options,
+                        std::vector<Quadric>& quadrics);
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_CLUSTER_HPP
@@ -13,6 +13,10 @@
 namespace MeshSimpl {
 namespace Internal {
 
+// dirty edges planned by one thread; most collapses dirty fewer edges than
+// this and are planned on the calling thread without waking the helpers
+static const size_t REPLAN_GRAIN = 32;
+
 void Collapser::collect() {
   for (order i : {0, 1}) {
     idx v = target->endpoint(i);
@@ -46,9 +50,9 @@ void Collapser::findCoincideEdges(idx vKept) {
     return nb0->secondV() < nb1->secondV();
   };
 
-  std::array<std::vector<const Neighbor*>, 2> pointers;
+  auto& pointers = sortedNeighbors;
   for (int i : {0, 1}) {
-    pointers[i].reserve(neighbors[i].size());
+    pointers[i].clear();
     for (const auto& nb : neighbors[i]) pointers[i].push_back(&nb);
     std::sort(pointers[i].begin(), pointers[i].end(), cmp);
   }
@@ -87,11 +91,9 @@ bool Collapser::cleanup() {
   assert(e0->endpoints() == e1->endpoints());
 
   idx vKept = it->vKept;
-  vertices.reduceQByHalf(vKept);
-  idx vKeptFork = vertices.duplicate(vKept);
+  idx vKeptFork = fork(vKept);
   idx vOther = it->vOther;
-  vertices.reduceQByHalf(vOther);
-  idx vOtherFork = vertices.duplicate(vOther);
+  idx vOtherFork = fork(vOther);
   vertices.setBoundary(vKeptFork, false);
 
   idx fExch0;
@@ -163,22 +165,22 @@ bool Collapser::cleanup() {
 
   //  insert edges around vOther to dirtyEdges
   nb.replace(e0, 0, vOther);
-  dirtyEdges.insert(nb.secondEdge());
+  dirtyEdges.push_back(nb.secondEdge());
   while (!nb.secondEdge()->onBoundary()) {
     nb.rotate();
-    dirtyEdges.insert(nb.secondEdge());
+    dirtyEdges.push_back(nb.secondEdge());
     if (nb.secondEdge() == e0) {
       break;  // completes a circle and all edges were inserted
     }
   }
   if (nb.secondEdge()->onBoundary()) {  // unfinished because met border
-    dirtyEdges.insert(e0);
+    dirtyEdges.push_back(e0);
     if (!e0->onBoundary()) {
       nb.replace(e0, 1, vOther);
-      dirtyEdges.insert(nb.secondEdge());
+      dirtyEdges.push_back(nb.secondEdge());
       while (!nb.secondEdge()->onBoundary()) {
         nb.rotate();
-        dirtyEdges.insert(nb.secondEdge());
+        dirtyEdges.push_back(nb.secondEdge());
         assert(nb.secondEdge() != e0);
         if (nb.secondEdge()->onBoundary()) {
           break;  //  all edges were inserted
@@ -216,7 +218,7 @@ bool Collapser::cleanup() {
     std::get<0>(ere)->replaceEndpoint(std::get<1>(ere), std::get<2>(ere));
   }
   for (auto& fsv : facesSetV)
-    faces.setV(std::get<0>(fsv), std::get<1>(fsv), std::get<2>(fsv));
+    setV(std::get<0>(fsv), std::get<1>(fsv), std::get<2>(fsv));
 
   updateNonManiGroup(vKept, vKeptFork);
 
@@ -280,6 +282,7 @@ int Collapser::collapse(Edge* edge) {
   // special case: two faces folded (#f=2, #v=3)
   // at this time topologyModifiable must be true
   if (!vertices.isBoundary(vDel) && neighbors[delOrd].empty()) {
+    if (trace) trace->begin(vKept, vDel, vertices.position(vKept));
     idx f0 = target->face(0);
     idx f1 = target->face(1);
     for (order ord : {0, 1, 2}) {
@@ -308,17 +311,31 @@ int Collapser::collapse(Edge* edge) {
 
   // there is topo change or not, collapse the target now. cleanup afterwords
   // update vertex data
+  if (trace) trace->begin(vKept, vDel, vertices.position(vKept));
   vertices.setPosition(vKept, target->center());
-  vertices.setQ(vKept, target->q());
+  if (trace) trace->setCenter(vertices.position(vKept));
+  if (!options.memoryless)
+    vertices.setQ(vKept, vertices.q(vKept) + vertices.q(vDel));
+  // the center is the position of vDel if it is fixed; keep it fixed there,
+  // standing for vDel
+  if (vertices.isFixed(vDel)) {
+    vertices.setFixed(vKept, true);
+    if (vertices.tracksOrigins())
+      vertices.setOrigin(vKept, vertices.origin(vDel));
+  } else if (options.keepVertices && vertices.tracksOrigins() &&
+             target->center() == vertices.position(vDel)) {
+    // likewise if the center is vDel when vertices are kept
+    vertices.setOrigin(vKept, vertices.origin(vDel));
+  }
 
   // replace face corner
   for (auto& nb : neighbors[delOrd]) {
-    faces.setV(nb.f(), nb.center(), vKept);
+    setV(nb.f(), nb.center(), vKept);
   }
 
-  std::array<std::vector<Edge*>, 2> initDirtyEdges;  // all edges around vv
   // collect edges who need update around endpoint 0 and 1
   for (int i : {0, 1}) {
+    initDirtyEdges[i].clear();
     if (!vertices.isBoundary(target->endpoint(i))) {
       auto it = neighbors[i].begin();
       initDirtyEdges[i].push_back(it->firstEdge());
@@ -343,11 +360,8 @@ int Collapser::collapse(Edge* edge) {
   }
 
   // update error of edges
-  for (auto& ide : initDirtyEdges) {
-    for (auto e : ide) {
-      dirtyEdges.insert(e);
-    }
-  }
+  for (auto& ide : initDirtyEdges)
+    dirtyEdges.insert(dirtyEdges.end(), ide.begin(), ide.end());
 
   // take away face 0 and 1
   std::array<bool, 2> edgeValid = {true, true};
@@ -382,8 +396,7 @@ int Collapser::collapse(Edge* edge) {
   // special case: component is separated
   if (neck && edgeValid[0] && edgeValid[1]) {
     Edge* seed = edgeKept[1];
-    vertices.reduceQByHalf(vKept);
-    idx vFork = vertices.duplicate(vKept);
+    idx vFork = fork(vKept);
     std::vector<Neighbor> dirtyNeighbors;
 
     for (int column : {0, 1}) {
@@ -399,7 +412,7 @@ int Collapser::collapse(Edge* edge) {
 
     seed->replaceEndpoint(vKept, vFork);
     for (auto& nb : dirtyNeighbors) {
-      faces.setV(nb.f(), nb.center(), vFork);
+      setV(nb.f(), nb.center(), vFork);
       nb.secondEdge()->replaceEndpoint(vKept, vFork);
     }
 
@@ -408,29 +421,116 @@ int Collapser::collapse(Edge* edge) {
 
   while (cleanup())
     ;
+  sortDirtyEdges();
 
   // when border is not fixed, never does any edge need to be marked removed
   if (!options.fixedVertices.empty() || options.fixBoundary) {
     for (auto dirty : dirtyEdges) {
-      // some edge might not be included in heap before this operation (both
+      // some edge might not be included in queue before this operation (both
       // endpoints on border) but now should be because of change of
-      // endpoint(s). unmark to add it back to heap and then update. it will be
-      // updated if needs to and will be marked as deleted again if is still a
-      // border with both endpoints on border
-      heap.unmarkRemoved(dirty);
+      // endpoint(s). unmark to add it back to queue and then update. it will
+      // be updated if needs to and will be marked as deleted again if is still
+      // a border with both endpoints on border
+      queue.unmarkRemoved(dirty);
+    }
+  }
+
+  if (options.memoryless) collectRing();
+
+  replan();
+
+  return accept();
+}
+
+idx Collapser::fork(idx v) {
+  vertices.reduceQByHalf(v);
+  const idx vFork = vertices.duplicate(v);
+  if (trace) trace->fork(vFork, v);
+  return vFork;
+}
+
+void Collapser::collectRing() {
+  ringEdges.assign(dirtyEdges.begin(), dirtyEdges.end());
+  for (Edge* edge : ringEdges) {
+    if (!edge->exists()) continue;
+    for (order i : {0, 1}) {
+      visitFan(vertices, faces, edge, edge->endpoint(i),
+               [this](const Neighbor& nb) {
+                 if (queue.contains(nb.secondEdge()))
+                   dirtyEdges.push_back(nb.secondEdge());
+               });
     }
   }
+}
+
+void Collapser::replan() {
+  // erased edges are skipped when they reach the top of queue, their plans
+  // do not matter
+  sortDirtyEdges();
+  replanned.clear();
+  for (Edge* dirty : dirtyEdges)
+    if (dirty->exists()) replanned.push_back(dirty);
+  plans.resize(replanned.size());
+
+  // planning only reads vertices and faces, so dirty edges can be planned
+  // concurrently
+  if (!options.memoryless) {
+    pool.parallelFor(replanned.size(), REPLAN_GRAIN,
+                     [this](size_t b, size_t e) {
+                       for (size_t i = b; i < e; ++i)
+                         plans[i] = replanned[i]->computePlan(
+                             edgeQuadric(vertices, faces, *replanned[i],
+                                         options),
+                             options.keepVertices);
+                     });
+  } else {
+    // endpoints are shared by many dirty edges: compute the quadric of each
+    // once, traversing its fan from the first dirty edge on it
+    fans.clear();
+    for (const Edge* dirty : replanned)
+      for (idx v : dirty->endpoints()) fans.emplace_back(v, dirty);
+    std::sort(fans.begin(), fans.end());
+    fans.erase(std::unique(fans.begin(), fans.end(),
+                           [](const Fan& a, const Fan& b) {
+                             return a.first == b.first;
+                           }),
+               fans.end());
+    fanQuadrics.resize(fans.size());
+    pool.parallelFor(fans.size(), REPLAN_GRAIN, [this](size_t b, size_t e) {
+      for (size_t i = b; i < e; ++i)
+        fanQuadrics[i] = fanQuadric(vertices, faces, *fans[i].second,
+                                    fans[i].first, options);
+    });
+
+    const auto quadricOf = [this](idx v) -> const Quadric& {
+      const auto it = std::lower_bound(
+          fans.begin(), fans.end(), v,
+          [](const Fan& fan, idx u) { return fan.first < u; });
+      return fanQuadrics[it - fans.begin()];
+    };
+    pool.parallelFor(replanned.size(), REPLAN_GRAIN,
+                     [&](size_t b, size_t e) {
+                       for (size_t i = b; i < e; ++i) {
+                         const vec2i& vv = replanned[i]->endpoints();
+                         plans[i] = replanned[i]->computePlan(
+                             quadricOf(vv[0]) + quadricOf(vv[1]),
+                             options.keepVertices);
+                       }
+                     });
+  }
 
-  for (auto& dirty : dirtyEdges) {
+  // plans are applied and fixed in queue one by one, in the same order as a
+  // serial run, so a heap never holds more than one out-of-place key
+  for (size_t i = 0; i < replanned.size(); ++i) {
+    Edge* dirty = replanned[i];
     double errorPrev = dirty->error();
-    if (dirty->planCollapse()) {
-      heap.fix(dirty, errorPrev);
+    dirty->applyPlan(plans[i]);
+    if (plans[i].valid) {
+      queue.fix(dirty, errorPrev);
     } else {
-      heap.markRemoved(dirty);
+      queue.markRemoved(dirty);
     }
   }
-
-  return accept();
 }
 
 void Collapser::updateNonManiGroup(idx vKept, idx vFork) {
@@ -5,17 +5,20 @@
 #ifndef MESH_SIMPL_COLLAPSER_HPP
 #define MESH_SIMPL_COLLAPSER_HPP
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <initializer_list>
-#include <set>
+#include <utility>
 #include <vector>
 
 #include "edge.hpp"
 #include "faces.hpp"
 #include "neighbor.hpp"
+#include "parallel.hpp"
 #include "proc.hpp"
-#include "qemheap.hpp"
+#include "edgequeue.hpp"
+#include "trace.hpp"
 #include "types.hpp"
 
 namespace MeshSimpl {
@@ -27,13 +30,32 @@ class Collapser {
  private:
   Vertices& vertices;
   Faces& faces;
-  QEMHeap& heap;
+  EdgeQueue& queue;
+  ThreadPool& pool;
   Edge* target;
   const SimplifyOptions& options;
 
-  std::array<std::vector<Neighbor>, 2> neighbors;
+  std::array<Array<Neighbor>, 2> neighbors;
   int fRemoved;
-  std::set<Edge*> dirtyEdges;
+
+  // edges whose plans change; may hold duplicates until sortDirtyEdges()
+  Array<Edge*> dirtyEdges;
+
+  // scratch space of a collapse, kept to reuse its storage
+  std::array<Array<const Neighbor*>, 2> sortedNeighbors;
+  std::array<Array<Edge*>, 2> initDirtyEdges;
+  Array<Edge*> ringEdges;
+
+  // dirty edges in the order they are fixed in heap and their new plans;
+  // plans are computed on the thread pool
+  Array<Edge*> replanned;
+  Array<Edge::Plan> plans;
+
+  // in memoryless mode, endpoints of dirty edges with an edge to traverse
+  // their fans from, sorted by vertex, and their quadrics
+  typedef std::pair<idx, const Edge*> Fan;
+  Array<Fan> fans;
+  Array<Quadric> fanQuadrics;
 
   // Represent a pair of coincided edges. Although there is never a non-manifold
   // edge created during the whole process, the coincided edges will become
@@ -47,10 +69,20 @@ class Collapser {
     NonManiInfo(idx vKept, idx vOther, Edge* e0, Edge* e1)
         : vKept(vKept), vOther(vOther), edges({e0, e1}), status(0) {}
   };
-  std::vector<NonManiInfo> nonMani;
+  Array<NonManiInfo> nonMani;
+
+  // accepted collapses are recorded into it if not null
+  CollapseTrace* trace = nullptr;
 
   void visitNonMani(idx vKept, idx vOther);
 
+  // Sort dirty edges by address, as they are in `edges`, and drop duplicates
+  void sortDirtyEdges() {
+    std::sort(dirtyEdges.begin(), dirtyEdges.end());
+    dirtyEdges.erase(std::unique(dirtyEdges.begin(), dirtyEdges.end()),
+                     dirtyEdges.end());
+  }
+
   void reset() {
     fRemoved = 0;
     target = nullptr;
@@ -66,17 +98,26 @@ class Collapser {
   }
 
   int reject() {
-    heap.penalize(target);
+    queue.penalize(target);
     assert(fRemoved == 0);
     reset();
     return fRemoved;
   }
 
   void eraseF(idx f) {
+    if (trace) trace->eraseFace(f, faces.indices(f));
     faces.erase(f);
     ++fRemoved;
   }
 
+  void setV(idx f, order k, idx v) {
+    if (trace) trace->setV(f, k, faces.v(f, k), v);
+    faces.setV(f, k, v);
+  }
+
+  // Split v into two vertices sharing its quadric, v and the returned fork
+  idx fork(idx v);
+
   // Store neighbors around endpoint(i) into neighbors[i], where i in {0, 1}
   void collect();
 
@@ -104,12 +145,20 @@ class Collapser {
 
   void updateNonManiGroup(idx vKept, idx vFork);
 
+  // In memoryless mode, the error of an edge depends on the faces around both
+  // endpoints: add edges around the other endpoints of dirty edges to them
+  void collectRing();
+
+  // Plan collapses of dirty edges and update their priorities in queue
+  void replan();
+
  public:
-  Collapser(Vertices& vertices, Faces& faces, QEMHeap& heap,
-            const SimplifyOptions& options)
+  Collapser(Vertices& vertices, Faces& faces, EdgeQueue& queue,
+            ThreadPool& pool, const SimplifyOptions& options)
       : vertices(vertices),
         faces(faces),
-        heap(heap),
+        queue(queue),
+        pool(pool),
         target(nullptr),
         options(options),
         neighbors(),
@@ -117,6 +166,9 @@ class Collapser {
         nonMani() {}
 
   int collapse(Edge* edge);
+
+  // Record accepted collapses into `trace`, or stop if null
+  void setTrace(CollapseTrace* trace) { this->trace = trace; }
 };
 
 }  // namespace Internal
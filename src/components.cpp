@@ -0,0 +1,72 @@
+#include "components.hpp"
+
+#include <limits>
+
+namespace MeshSimpl {
+namespace Internal {
+
+std::vector<Component> splitComponents(const Positions& positions,
+                                       const Indices& indices) {
+  // every side of a face is an edge, so uniting the corners of faces unites
+  // exactly the endpoints of every edge
+  UnionFind sets(positions.size());
+  for (const auto& face : indices) {
+    sets.unite(face[0], face[1]);
+    sets.unite(face[1], face[2]);
+  }
+
+  const idx NONE = std::numeric_limits<idx>::max();
+  std::vector<idx> componentOf(positions.size(), NONE);  // indexed by root
+  std::vector<Component> components;
+  for (const auto& face : indices) {
+    idx& c = componentOf[sets.find(face[0])];
+    if (c == NONE) {
+      c = components.size();
+      components.emplace_back();
+    }
+  }
+
+  // vertices in ascending order, so a mesh of one component stays the same
+  std::vector<bool> referenced(positions.size(), false);
+  for (const auto& face : indices)
+    for (idx v : face) referenced[v] = true;
+  std::vector<idx> localIndex(positions.size(), NONE);
+  for (idx v = 0; v < positions.size(); ++v) {
+    if (!referenced[v]) continue;
+    Component& component = components[componentOf[sets.find(v)]];
+    localIndex[v] = component.vertices.size();
+    component.vertices.push_back(v);
+    component.mesh.positions.push_back(positions[v]);
+  }
+
+  for (const auto& face : indices) {
+    components[componentOf[sets.find(face[0])]].mesh.indices.push_back(
+        {localIndex[face[0]], localIndex[face[1]], localIndex[face[2]]});
+  }
+
+  return components;
+}
+
+void joinComponents(const std::vector<Component>& components,
+                    Positions& positions, Indices& indices) {
+  size_t nv = 0, nf = 0;
+  for (const auto& component : components) {
+    nv += component.mesh.positions.size();
+    nf += component.mesh.indices.size();
+  }
+
+  positions.clear();
+  indices.clear();
+  positions.reserve(nv);
+  indices.reserve(nf);
+  for (const auto& component : components) {
+    const idx offset = positions.size();
+    positions.insert(positions.end(), component.mesh.positions.begin(),
+                     component.mesh.positions.end());
+    for (const auto& face : component.mesh.indices)
+      indices.push_back({face[0] + offset, face[1] + offset, face[2] + offset});
+  }
+}
+
+}  // namespace Internal
+}  // namespace MeshSimpl
@@ -0,0 +1,56 @@
+#ifndef MESH_SIMPL_COMPONENTS_HPP
+#define MESH_SIMPL_COMPONENTS_HPP
+
+#include <vector>
+
+#include "types.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+// Disjoint sets of vertices with path halving; the smaller index becomes the
+// root of a union so labels do not depend on the order of unions
+class UnionFind {
+ private:
+  std::vector<idx> parent;
+
+ public:
+  explicit UnionFind(size_t sz) : parent(sz) {
+    for (idx i = 0; i < sz; ++i) parent[i] = i;
+  }
+
+  idx find(idx i) {
+    while (parent[i] != i) i = parent[i] = parent[parent[i]];
+    return i;
+  }
+
+  void unite(idx i, idx j) {
+    i = find(i);
+    j = find(j);
+    if (i < j)
+      parent[j] = i;
+    else
+      parent[i] = j;
+  }
+};
+
+// A connected component cut out of a mesh
+struct Component {
+  Mesh mesh;
+  std::vector<idx> vertices;  // vertices[v] is the index of v in the mesh
+};
+
+// Split a mesh into connected components, i.e., sets of faces connected
+// through their sides. Components are ordered by their first face and keep
+// the order of faces and vertices; unreferenced vertices are dropped
+std::vector<Component> splitComponents(const Positions& positions,
+                                       const Indices& indices);
+
+// Concatenate meshes into one
+void joinComponents(const std::vector<Component>& components,
+                    Positions& positions, Indices& indices);
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_COMPONENTS_HPP
@@ -22,9 +22,6 @@ class Edge : public Erasable {
  private:
   Vertices &vertices;
 
-  // sum of quadrics of two endpoints
-  Quadric _q = {};
-
   // where this edge collapse into
   vec3d _center = {};
 
@@ -67,9 +64,6 @@ class Edge : public Erasable {
   // Returns the error value made of next collapse
   double error() const { return _error; }
 
-  // Returns the sum of quadrics of two endpoints
-  const Quadric &q() const { return _q; }
-
   bool bothEndsOnBoundary() const {
     return vertices.isBoundary(_vv[0]) && vertices.isBoundary(_vv[1]);
   }
@@ -107,12 +101,37 @@ class Edge : public Erasable {
   // public methods for update
   //
 
+  // Outcome of planning the next collapse; `valid` is false if this edge
+  // will never be collapsed
+  struct Plan {
+    vec3d center;
+    double error;
+    bool valid;
+  };
+
+  // Plan next collapse minimizing quadric q, see edgeQuadric(), without
+  // modifying this edge; the center is one of the endpoints if `endpoints`.
+  // Safe to be called concurrently for different edges as long as vertices
+  // are not modified
+  Plan computePlan(const Quadric &q, bool endpoints) const;
+
+  // Store a plan returned by computePlan()
+  void applyPlan(const Plan &plan) {
+    if (plan.valid) {
+      _center = plan.center;
+      _error = plan.error;
+    }
+  }
+
   // Plan next collapse.
   // Will set
-  //  - what is current sum of endpoints quadrics
   //  - which position to collapse into (center)
   //  - what will be the error
-  bool planCollapse();
+  bool planCollapse(const Quadric &q, bool endpoints) {
+    const Plan plan = computePlan(q, endpoints);
+    applyPlan(plan);
+    return plan.valid;
+  }
 
   void setErrorInfty() { _error = std::numeric_limits<double>::max(); }
 
@@ -0,0 +1,56 @@
+#ifndef MESH_SIMPL_EDGEQUEUE_HPP
+#define MESH_SIMPL_EDGEQUEUE_HPP
+
+#include <cstddef>
+
+#include "types.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+// Selects the edge to collapse next among the edges of a mesh, given their
+// planned errors. Edges are erased and re-planned behind its back; the
+// collapser tells it which edges changed through fix(), penalize() and the
+// removal marks.
+class EdgeQueue {
+ public:
+  virtual ~EdgeQueue() = default;
+
+  // Forget all edges and take the edges as they are now, e.g., of another
+  // mesh, keeping storage; prioritize() is to be called again
+  virtual void reset() = 0;
+
+  // Order edges once all of them are planned and marked; called once before
+  // anything else
+  virtual void prioritize() = 0;
+
+  // Returns the edge to collapse next or nullptr if none is left. It is
+  // possible that the output is an erased edge or it has been removed from
+  // queue, then pop() it and ask again
+  virtual Edge *top() = 0;
+
+  // Remove the top edge from queue
+  virtual void pop() = 0;
+
+  // Fix the priority of an edge after the error value is modified;
+  // Param `errorPrev` is used to determine the direction of priority change
+  virtual void fix(const Edge *edge, double errorPrev) = 0;
+
+  // Suppress this edge until it is, if ever, updated next time
+  virtual void penalize(Edge *edge) = 0;
+
+  // Returns true if no edge is left
+  virtual bool empty() const = 0;
+
+  // Returns true if the edge is not marked as removed
+  virtual bool contains(const Edge *edge) const = 0;
+
+  // Mark removed, i.e., never to be selected until unmarked and fixed
+  virtual void markRemoved(const Edge *edge) = 0;
+  virtual void unmarkRemoved(const Edge *edge) = 0;
+};
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_EDGEQUEUE_HPP
@@ -0,0 +1,84 @@
+#include "edgesampler.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+const idx EdgeSampler::NONE;
+
+EdgeSampler::EdgeSampler(Edges &edges, unsigned samples, uint64_t seed)
+    : edges(edges), samples(samples), seed(seed) {
+  reset();
+}
+
+void EdgeSampler::reset() {
+  rng.seed(seed);
+  live.clear();
+  slots.assign(edges.size(), NONE);
+  removed.assign(edges.size(), false);
+  choice = nullptr;
+}
+
+void EdgeSampler::prioritize() {
+  for (idx e = 0; e < edges.size(); ++e)
+    if (!removed[e]) insert(e);
+}
+
+Edge *EdgeSampler::top() {
+  if (choice) return choice;
+
+  for (unsigned drawn = 0; drawn < samples && !live.empty();) {
+    const idx e = live[rng() % live.size()];
+    if (!edges[e].exists()) {
+      drop(e);
+      continue;
+    }
+    ++drawn;
+
+    // ties go to the smaller id as in QEMHeap
+    const Edge *edge = &edges[e];
+    if (!choice || edge->error() < choice->error() ||
+        (edge->error() == choice->error() && e < id(choice)))
+      choice = &edges[e];
+  }
+  return choice;
+}
+
+void EdgeSampler::pop() {
+  if (choice) drop(id(choice));
+}
+
+void EdgeSampler::fix(const Edge *edge, double) {
+  const idx e = id(edge);
+  if (!removed[e]) insert(e);
+  if (edge == choice) choice = nullptr;
+}
+
+void EdgeSampler::penalize(Edge *edge) {
+  edge->setErrorInfty();
+  drop(id(edge));
+}
+
+void EdgeSampler::markRemoved(const Edge *edge) {
+  const idx e = id(edge);
+  removed[e] = true;
+  drop(e);
+}
+
+void EdgeSampler::insert(idx e) {
+  if (slots[e] != NONE) return;
+  slots[e] = live.size();
+  live.push_back(e);
+}
+
+void EdgeSampler::drop(idx e) {
+  if (slots[e] == NONE) return;
+  if (choice == &edges[e]) choice = nullptr;
+  const idx last = live.back();
+  live[slots[e]] = last;
+  slots[last] = slots[e];
+  live.pop_back();
+  slots[e] = NONE;
+}
+
+}  // namespace Internal
+}  // namespace MeshSimpl
@@ -0,0 +1,75 @@
+#ifndef MESH_SIMPL_EDGESAMPLER_HPP
+#define MESH_SIMPL_EDGESAMPLER_HPP
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "edge.hpp"
+#include "edgequeue.hpp"
+#include "types.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+// Multiple-choice selection (Wu and Kobbelt): the next edge is the one of
+// least error among a few edges drawn at random from the edges neither
+// removed nor penalized. No order is kept, so updates take constant time
+// instead of logarithmic, at the cost of collapses slightly out of order.
+// Draws are reproducible for a given seed.
+class EdgeSampler final : public EdgeQueue {
+ public:
+  EdgeSampler(Edges &edges, unsigned samples, uint64_t seed);
+
+  // Also restarts the draws from the seed
+  void reset() override;
+
+  void prioritize() override;
+
+  // Returns the best of `samples` edges drawn, the same edge until it is
+  // popped, penalized, removed or fixed
+  Edge *top() override;
+
+  void pop() override;
+
+  void fix(const Edge *edge, double errorPrev) override;
+
+  void penalize(Edge *edge) override;
+
+  // Returns true if no edge can be drawn; erased edges are only dropped when
+  // drawn, so top() may still return nullptr when this is false
+  bool empty() const override { return live.empty(); }
+
+  bool contains(const Edge *edge) const override {
+    return !removed[id(edge)];
+  }
+
+  void markRemoved(const Edge *edge) override;
+  void unmarkRemoved(const Edge *edge) override {
+    removed[id(edge)] = false;
+  }
+
+ private:
+  static const idx NONE = std::numeric_limits<idx>::max();
+
+  Edges &edges;
+  const unsigned samples;
+  const uint64_t seed;
+  std::mt19937_64 rng;
+  Array<idx> live;         // edges that can be drawn, in no order
+  Array<idx> slots;        // slots[e] is the position of e in live or NONE
+  Array<bool> removed;     // erased from queue
+  Edge *choice = nullptr;  // the edge top() returns until it changes
+
+  idx id(const Edge *edge) const { return edge - edges.data(); }
+
+  // Add an edge to or drop an edge from the ones that can be drawn
+  void insert(idx e);
+  void drop(idx e);
+};
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_EDGESAMPLER_HPP
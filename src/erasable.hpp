@@ -5,8 +5,11 @@
 #ifndef MESH_SIMPL_ERASABLE_HPP
 #define MESH_SIMPL_ERASABLE_HPP
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <vector>
+#include "memory.hpp"
 #include "types.hpp"
 
 namespace MeshSimpl {
@@ -26,7 +29,7 @@ class Erasable {
 
 class Erasables {
  protected:
-  std::vector<bool> _erased;
+  Array<bool> _erased;
 
  public:
   explicit Erasables(size_t sz) : _erased(sz, false) {}
@@ -42,6 +45,25 @@ class Erasables {
   }
 
   size_t size() const { return _erased.size(); }
+
+  // Number of elements not erased
+  size_t count() const {
+    return std::count(_erased.begin(), _erased.end(), false);
+  }
+
+  // Compact elements not erased to the front: fill erased slots from the
+  // back, calling move(from, to) for each element moved. Returns the number
+  // of elements not erased; those in front of it which exist stay in place
+  template <typename Move>
+  size_t compactOrder(Move move) const {
+    for (std::ptrdiff_t lo = 0, hi = std::ptrdiff_t(size()) - 1; true;
+         ++lo, --hi) {
+      while (lo <= hi && exists(lo)) ++lo;
+      while (lo < hi && !exists(hi)) --hi;
+      if (lo >= hi) return lo;
+      move(hi, lo);
+    }
+  }
 };
 
 }  // namespace Internal
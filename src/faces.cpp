@@ -30,19 +30,24 @@ vec3d Faces::edgeVec(idx f, order k, const Vertices& vertices) const {
 }
 
 void Faces::compactIndicesAndDie(Indices& indices) {
-  for (int lo = 0, hi = size() - 1; true; ++lo, --hi) {
-    while (lo <= hi && exists(lo)) ++lo;
-    while (lo < hi && !exists(hi)) --hi;
-    if (lo >= hi) {
-      _indices.resize(lo);
-      break;
-    }
-    std::swap(_indices[lo], _indices[hi]);
-  }
+  const size_t nf = compactOrder(
+      [&](idx from, idx to) { std::swap(_indices[from], _indices[to]); });
+  _indices.resize(nf);
 
   // move to output
   indices = std::move(_indices);
 }
 
+void Faces::writeCompacted(const std::vector<idx>& renumbered,
+                           vec3i* indices) const {
+  const auto write = [&](idx from, idx to) {
+    for (order k = 0; k < 3; ++k)
+      indices[to][k] = renumbered[_indices[from][k]];
+  };
+  const size_t nf = compactOrder(write);
+  for (idx f = 0; f < nf; ++f)
+    if (exists(f)) write(f, f);
+}
+
 }  // namespace Internal
 }  // namespace MeshSimpl
@@ -12,6 +12,7 @@
 #include <ext/alloc_traits.h>
 
 #include "erasable.hpp"
+#include "numa.hpp"
 #include "types.hpp"
 
 namespace MeshSimpl {
@@ -25,7 +26,7 @@ class Faces : public Erasables {
   Indices _indices;
   // FIXME: BAD idea to use pointers. this program never resizes the vector
   // edges so these pointers are never invalidated, but it still is bad manner
-  std::vector<std::array<Edge*, 3>> _sides;
+  Array<std::array<Edge*, 3>> _sides;
 
  public:
   // Embed indices and allocate space for sides
@@ -34,6 +35,13 @@ class Faces : public Erasables {
         _indices(std::move(indices)),
         _sides(size()) {}
 
+  // Embed other indices, copied into the storage of the ones before
+  void reset(const Indices& indices) {
+    _erased.assign(indices.size(), false);
+    _indices.assign(indices.begin(), indices.end());
+    _sides.resize(size());
+  }
+
   // Get/set side: edge of a face
   Edge* side(idx f, order ord) const {
     assert(exists(f));
@@ -68,6 +76,18 @@ class Faces : public Erasables {
 
   void compactIndicesAndDie(Indices& indices);
 
+  // Write indices of faces not erased, in the order of
+  // compactIndicesAndDie(), with vertices renumbered as Vertices does
+  void writeCompacted(const std::vector<idx>& renumbered,
+                      vec3i* indices) const;
+
+  // Place indices and sides on NUMA nodes, see NumaLayout
+  void place(const NumaLayout& numa, MemoryPlacement placement,
+             unsigned parts) const {
+    numa.place(_indices, placement, parts);
+    numa.place(_sides, placement, parts);
+  }
+
   // Return the order of a vertex v in some face f
   order orderOf(idx f, idx v) const {
     if (v == indices(f)[0])
@@ -0,0 +1,73 @@
+#include "grid.hpp"
+
+#include <cassert>
+
+#include "edge.hpp"
+#include "faces.hpp"
+#include "proc.hpp"
+#include "vertices.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+Indices gridIndices(size_t width, size_t height) {
+  Indices indices;
+  indices.reserve(2 * (width - 1) * (height - 1));
+  for (size_t j = 0; j + 1 < height; ++j) {
+    for (size_t i = 0; i + 1 < width; ++i) {
+      const idx a = j * width + i, b = a + 1, c = b + width, d = a + width;
+      indices.push_back({a, b, c});
+      indices.push_back({a, c, d});
+    }
+  }
+  return indices;
+}
+
+void buildGridConnectivity(size_t width, size_t height, Vertices& vertices,
+                           Faces& faces, Edges& edges) {
+  // the two faces of cell (i, j)
+  const auto lower = [width](size_t i, size_t j) -> idx {
+    return 2 * (j * (width - 1) + i);
+  };
+  const auto upper = [&](size_t i, size_t j) { return lower(i, j) + 1; };
+
+  // attach the wings, in order of face as sorting would
+  const auto attach = [&](Edge& edge, idx f, order k) {
+    const order wing = edge.ordInF(0) == INVALID ? 0 : 1;
+    edge.setWing(wing, f, k);
+    faces.setSide(f, k, &edge);
+  };
+
+  // edges with v as smaller endpoint are, in order of the larger one,
+  // (v, v + 1), (v, v + width) and the diagonal (v, v + width + 1); this is
+  // the order of edges sorted by endpoints
+  edges.reserve((width - 1) * height + width * (height - 1) +
+                (width - 1) * (height - 1));
+  for (size_t j = 0; j < height; ++j) {
+    for (size_t i = 0; i < width; ++i) {
+      const idx v = j * width + i;
+      if (i + 1 < width) {
+        edges.emplace_back(vertices, v, v + 1);
+        if (j > 0) attach(edges.back(), upper(i, j - 1), 0);
+        if (j + 1 < height) attach(edges.back(), lower(i, j), 2);
+      }
+      if (j + 1 < height) {
+        edges.emplace_back(vertices, v, v + width);
+        if (i > 0) attach(edges.back(), lower(i - 1, j), 0);
+        if (i + 1 < width) attach(edges.back(), upper(i, j), 1);
+      }
+      if (i + 1 < width && j + 1 < height) {
+        edges.emplace_back(vertices, v, v + width + 1);
+        attach(edges.back(), lower(i, j), 1);
+        attach(edges.back(), upper(i, j), 2);
+      }
+      if (i == 0 || j == 0 || i + 1 == width || j + 1 == height)
+        vertices.setBoundary(v, true);
+    }
+  }
+
+  assert(edgeTopoCorrectness(faces, edges));
+}
+
+}  // namespace Internal
+}  // namespace MeshSimpl
@@ -0,0 +1,29 @@
+#ifndef MESH_SIMPL_GRID_HPP
+#define MESH_SIMPL_GRID_HPP
+
+#include <cstddef>
+
+#include "types.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+class Faces;
+class Vertices;
+
+// Faces of a regular grid of width x height vertices, vertex (i, j) being
+// j * width + i. The cell (i, j) with corners a = (i, j), b = (i + 1, j),
+// c = (i + 1, j + 1) and d = (i, j + 1) is split along ac into faces (a, b, c)
+// and (a, c, d), numbered 2 * (j * (width - 1) + i) and the next
+Indices gridIndices(size_t width, size_t height);
+
+// Same as buildConnectivity() for faces made by gridIndices(), but derives
+// edges from grid coordinates instead of sorting sides; edges, their wings and
+// boundary flags come out identical
+void buildGridConnectivity(size_t width, size_t height, Vertices& vertices,
+                           Faces& faces, Edges& edges);
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_GRID_HPP
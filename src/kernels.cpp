@@ -0,0 +1,350 @@
+#include "kernels.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+#include "faces.hpp"
+#include "neighbor.hpp"
+#include "simplify.hpp"
+#include "util.hpp"
+#include "vertices.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MESH_SIMPL_X86
+#endif
+
+namespace MeshSimpl {
+namespace Internal {
+namespace {
+
+// Bodies of the kernels, inlined into one entry point per ISA level
+
+inline Edge::Plan plan(const Vertices &vertices, const vec2i &vv,
+                       const Quadric &q, bool endpoints) {
+  Edge::Plan plan;
+  vec3d &center = plan.center;
+  double &error = plan.error;
+  plan.valid = true;
+
+  std::array<bool, 2> vvFixed{vertices.isFixed(vv[0]), vertices.isFixed(vv[1])};
+
+  if (vvFixed[0] && vvFixed[1]) {
+    // the plan is: no plan is needed because it will never by modified
+    plan.valid = false;
+    return plan;
+  }
+
+  if (vvFixed[0] != vvFixed[1]) {
+    // the plan is: new position is the position of the vertex who's fixed
+    center = vertices.position(vv[vvFixed[0] ? 0 : 1]);
+    error = q.error(center);
+    return plan;
+  }
+
+  if (endpoints) {
+    // the plan is: new position is the endpoint leading to the lower error
+    center = vertices.position(vv[0]);
+    error = q.error(center);
+    const vec3d other = vertices.position(vv[1]);
+    const double err = q.error(other);
+    if (err < error) {
+      center = other;
+      error = err;
+    }
+    return plan;
+  }
+
+  // the plan is: new position leads to the lowest error
+
+  // computes the inverse of matrix A in quadric
+  const double aDet = q.aDeterminant();
+
+  if (aDet != 0) {
+    // invertible, find position yielding minimal error
+    std::tie(center, error) = q.optimal(aDet);
+
+    // prevent the optimal position from being too far. it is anticipated that
+    // such thing happens rarely, when there are coincide faces and the optimal
+    // value position might be galaxy away even though any position on their
+    // plane will have small enough error. error is kept as it is but we change
+    // the collapse center to one of the endpoint so it looks more natural
+    vec3d edgeVec = vertices.position(vv[1]) - vertices.position(vv[0]);
+    vec3d diffVec = center - vertices.position(vv[0]);
+    for (int i = 0; i < 3; ++i) {
+      double lambda = diffVec[i] / edgeVec[i] - 0.5;
+      if (std::abs(lambda) > 20) {
+        if (lambda > 0) {
+          center = vertices.position(vv[1]);
+        } else {
+          center = vertices.position(vv[0]);
+        }
+        break;
+      }
+    }
+
+    return plan;
+  }
+
+  // not invertible, choose from endpoints and midpoint
+  center = midpoint(vertices.position(vv[0]), vertices.position(vv[1]));
+  error = q.error(center);
+  for (const idx v : vv) {
+    const double err = q.error(vertices.position(v));
+    if (err < error) {
+      center = vertices.position(v);
+      error = err;
+    }
+  }
+
+  return plan;
+}
+
+inline bool isFaceFlipped(const Vertices &vertices, const Faces &faces, idx f,
+                          order moved, const vec3d &position, double angle) {
+  const vec3d &vk = faces.vPos(f, moved, vertices);
+  const vec3d &vi = faces.vPos(f, next(moved), vertices);
+  const vec3d &vj = faces.vPos(f, prev(moved), vertices);
+  const vec3d edgeVec0 = vj - vi;
+  const vec3d edgeVec1 = vk - vj;
+  const vec3d edgeVec1New = position - vj;
+  vec3d normalPrv = cross(edgeVec0, edgeVec1);
+  double magPrv = magnitude(normalPrv);
+  if (magPrv != 0) {
+    vec3d normalNew = cross(edgeVec0, edgeVec1New);
+    double magNew = magnitude(normalNew);
+    if (magNew == 0) return true;
+    normalPrv /= magPrv;
+    normalNew /= magNew;
+    double cos = dot(normalPrv, normalNew);
+    return cos < angle;
+  } else {
+    return false;
+  }
+}
+
+inline bool isElongated(const vec3d &pos0, const vec3d &pos1,
+                        const vec3d &pos2, double ratio) {
+  assert(ratio > 0.0);
+  const vec3d vec01 = pos1 - pos0;
+  const vec3d vec02 = pos2 - pos0;
+  const vec3d vec12 = pos2 - pos1;
+  const double a = magnitude(vec01);
+  const double b = magnitude(vec12);
+  const double c = magnitude(vec02);
+  const double s = (a + b + c) / 2.0;
+  const double aspectRatioRecip = 8 * (s - a) * (s - b) * (s - c) / (a * b * c);
+  return aspectRatioRecip < ratio;
+}
+
+// Quadric of the plane of face f; false if the face is degenerate
+inline bool planeQuadric(const Vertices &vertices, const Faces &faces, idx f,
+                         const SimplifyOptions &options, Quadric &q) {
+  // calculate the plane of this face (n and d: n'v+d=0 defines the plane)
+  const vec3d edgeVec2 = faces.edgeVec(f, 2, vertices);
+  const vec3d edgeVec1 = faces.edgeVec(f, 1, vertices);
+  vec3d normal = cross(edgeVec2, edgeVec1);
+  // |normal| = area, used for normalization and weighting quadrics
+  const double area = magnitude(normal);
+  if (area != 0)
+    normal /= area;
+  else
+    return false;
+
+  // d = -n*v0
+  const double d = -dot(normal, faces.vPos(f, 0, vertices));
+
+  // calculate quadric Q = (A, b, c) = (nn', dn, d*d)
+  q = Quadric(normal, d);
+  if (options.weightByArea) q *= area;
+  return true;
+}
+
+// Quadric of the constraint plane through boundary side k of face f and
+// perpendicular to the face; false if the face is degenerate
+inline bool borderQuadric(const Vertices &vertices, const Faces &faces, idx f,
+                          order k, const SimplifyOptions &options,
+                          Quadric &q) {
+  const std::array<vec3d, 3> e{faces.edgeVec(f, 0, vertices),
+                               faces.edgeVec(f, 1, vertices),
+                               faces.edgeVec(f, 2, vertices)};
+  const vec3d nFace = cross(e[0], e[1]);
+
+  vec3d normal = cross(nFace, e[k]);
+  const double normalMag = magnitude(normal);
+  if (normalMag != 0)
+    normal /= normalMag;
+  else
+    return false;
+
+  const double d = -dot(normal, faces.vPos(f, next(k), vertices));
+  q = Quadric(normal, d);
+  q *= options.borderConstraint;
+  if (options.weightByArea) q *= magnitude(nFace);
+  return true;
+}
+
+inline Quadric fanQuadric(const Vertices &vertices, const Faces &faces,
+                          const Edge &edge, idx v,
+                          const SimplifyOptions &options) {
+  const bool constrained = constrainsBorders(options) && vertices.isBoundary(v);
+  Quadric sum{}, q;
+  visitFan(vertices, faces, &edge, v, [&](const Neighbor &nb) {
+    const idx f = nb.f();
+    if (planeQuadric(vertices, faces, f, options, q)) sum += q;
+    if (!constrained) return;
+    // boundary sides through v, i.e., not across from it
+    for (order k : {0, 1, 2})
+      if (k != nb.center() && faces.side(f, k)->onBoundary() &&
+          borderQuadric(vertices, faces, f, k, options, q))
+        sum += q;
+  });
+  return sum;
+}
+
+inline Quadric edgeQuadric(const Vertices &vertices, const Faces &faces,
+                           const Edge &edge,
+                           const SimplifyOptions &options) {
+  if (!options.memoryless)
+    return vertices.q(edge.endpoint(0)) + vertices.q(edge.endpoint(1));
+  return fanQuadric(vertices, faces, edge, edge.endpoint(0), options) +
+         fanQuadric(vertices, faces, edge, edge.endpoint(1), options);
+}
+
+inline void sortHalfEdges(HalfEdge *begin, HalfEdge *end) {
+  std::sort(begin, end, [](const HalfEdge &a, const HalfEdge &b) {
+    return a.key < b.key || (a.key == b.key && a.f < b.f);
+  });
+}
+
+// Define entry points of all kernels for one ISA level and their table
+#define MESH_SIMPL_KERNELS(LEVEL, ATTRIBUTES)                                  \
+  ATTRIBUTES Edge::Plan LEVEL##Plan(const Vertices &vertices,                  \
+                                    const vec2i &vv, const Quadric &q,         \
+                                    bool endpoints) {                          \
+    return plan(vertices, vv, q, endpoints);                                   \
+  }                                                                            \
+  ATTRIBUTES bool LEVEL##IsFaceFlipped(const Vertices &vertices,               \
+                                       const Faces &faces, idx f, order moved, \
+                                       const vec3d &position, double angle) {  \
+    return isFaceFlipped(vertices, faces, f, moved, position, angle);          \
+  }                                                                            \
+  ATTRIBUTES bool LEVEL##IsElongated(const vec3d &pos0, const vec3d &pos1,     \
+                                     const vec3d &pos2, double ratio) {        \
+    return isElongated(pos0, pos1, pos2, ratio);                               \
+  }                                                                            \
+  ATTRIBUTES bool LEVEL##PlaneQuadric(const Vertices &vertices,                \
+                                      const Faces &faces, idx f,               \
+                                      const SimplifyOptions &options,          \
+                                      Quadric &q) {                            \
+    return planeQuadric(vertices, faces, f, options, q);                       \
+  }                                                                            \
+  ATTRIBUTES bool LEVEL##BorderQuadric(const Vertices &vertices,               \
+                                       const Faces &faces, idx f, order k,     \
+                                       const SimplifyOptions &options,         \
+                                       Quadric &q) {                           \
+    return borderQuadric(vertices, faces, f, k, options, q);                   \
+  }                                                                            \
+  ATTRIBUTES Quadric LEVEL##FanQuadric(const Vertices &vertices,               \
+                                       const Faces &faces, const Edge &edge,   \
+                                       idx v,                                  \
+                                       const SimplifyOptions &options) {       \
+    return fanQuadric(vertices, faces, edge, v, options);                      \
+  }                                                                            \
+  ATTRIBUTES Quadric LEVEL##EdgeQuadric(const Vertices &vertices,              \
+                                        const Faces &faces, const Edge &edge,  \
+                                        const SimplifyOptions &options) {      \
+    return edgeQuadric(vertices, faces, edge, options);                        \
+  }                                                                            \
+  ATTRIBUTES void LEVEL##SortHalfEdges(HalfEdge *begin, HalfEdge *end) {       \
+    sortHalfEdges(begin, end);                                                 \
+  }                                                                            \
+  const Kernels LEVEL##Kernels = {                                             \
+      LEVEL##Plan,         LEVEL##IsFaceFlipped, LEVEL##IsElongated,           \
+      LEVEL##PlaneQuadric, LEVEL##BorderQuadric, LEVEL##FanQuadric,            \
+      LEVEL##EdgeQuadric,  LEVEL##SortHalfEdges};
+
+MESH_SIMPL_KERNELS(generic, )
+#ifdef MESH_SIMPL_X86
+MESH_SIMPL_KERNELS(sse42, __attribute__((target("sse4.2"), flatten)))
+MESH_SIMPL_KERNELS(avx2, __attribute__((target("avx2"), flatten)))
+MESH_SIMPL_KERNELS(avx512, __attribute__((target("avx512f"), flatten)))
+#endif
+
+#undef MESH_SIMPL_KERNELS
+
+const Kernels &table(IsaLevel level) {
+  switch (level) {
+#ifdef MESH_SIMPL_X86
+    case IsaLevel::SSE42:
+      return sse42Kernels;
+    case IsaLevel::AVX2:
+      return avx2Kernels;
+    case IsaLevel::AVX512:
+      return avx512Kernels;
+#endif
+    default:
+      return genericKernels;
+  }
+}
+
+// Level named by environment variable MESH_SIMPL_ISA if it names a supported
+// one, otherwise the best supported level
+IsaLevel initialIsaLevel() {
+  IsaLevel level = supportedIsaLevel();
+  const char *env = std::getenv("MESH_SIMPL_ISA");
+  if (env == nullptr) return level;
+
+  const std::pair<const char *, IsaLevel> names[] = {
+      {"generic", IsaLevel::GENERIC},
+      {"sse4.2", IsaLevel::SSE42},
+      {"avx2", IsaLevel::AVX2},
+      {"avx512", IsaLevel::AVX512}};
+  for (const auto &name : names)
+    if (std::strcmp(env, name.first) == 0 && name.second <= level)
+      return name.second;
+  return level;
+}
+
+std::atomic<IsaLevel> &activeIsaLevel() {
+  static std::atomic<IsaLevel> level(initialIsaLevel());
+  return level;
+}
+
+std::atomic<const Kernels *> &activeKernels() {
+  static std::atomic<const Kernels *> active(&table(activeIsaLevel()));
+  return active;
+}
+
+}  // namespace
+
+const Kernels &kernels() {
+  return *activeKernels().load(std::memory_order_relaxed);
+}
+
+}  // namespace Internal
+
+IsaLevel supportedIsaLevel() {
+#ifdef MESH_SIMPL_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return IsaLevel::AVX512;
+  if (__builtin_cpu_supports("avx2")) return IsaLevel::AVX2;
+  if (__builtin_cpu_supports("sse4.2")) return IsaLevel::SSE42;
+#endif
+  return IsaLevel::GENERIC;
+}
+
+IsaLevel isaLevel() { return Internal::activeIsaLevel(); }
+
+void setIsaLevel(IsaLevel level) {
+  if (level > supportedIsaLevel())
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: ISA level not supported by this CPU");
+  Internal::activeIsaLevel() = level;
+  Internal::activeKernels() = &Internal::table(level);
+}
+
+}  // namespace MeshSimpl
@@ -0,0 +1,76 @@
+#ifndef MESH_SIMPL_KERNELS_HPP
+#define MESH_SIMPL_KERNELS_HPP
+
+#include <cstdint>
+
+#include "edge.hpp"
+#include "types.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+class Faces;
+class Vertices;
+
+// A face side found while building connectivity: edge (v0, v1), v0 < v1, is
+// side k of face f. key = v0 << IDX_BITS | v1 so sides of one edge sort
+// together
+struct HalfEdge {
+#ifdef MESH_SIMPL_64BIT_INDEX
+  typedef unsigned __int128 Key;
+#else
+  typedef uint64_t Key;
+#endif
+  static const int IDX_BITS = 8 * sizeof(idx);
+
+  Key key;
+  idx f;
+  order k;
+
+  static Key makeKey(idx v0, idx v1) {
+    return static_cast<Key>(v0) << IDX_BITS | v1;
+  }
+
+  idx v0() const { return static_cast<idx>(key >> IDX_BITS); }
+  idx v1() const { return static_cast<idx>(key); }
+};
+
+// Returns true if boundaries get constraint planes, i.e., they are not
+// always fixed
+inline bool constrainsBorders(const SimplifyOptions& options) {
+  return !options.fixedVertices.empty() || !options.fixBoundary;
+}
+
+// Hot kernels compiled once per ISA level. The table for the level in use is
+// selected at startup, see setIsaLevel(). Every level yields bitwise
+// identical results: the kernels are compiled without contraction into
+// fused multiply-adds, so only the width of instructions differs
+struct Kernels {
+  Edge::Plan (*plan)(const Vertices& vertices, const vec2i& vv,
+                     const Quadric& q, bool endpoints);
+  bool (*isFaceFlipped)(const Vertices& vertices, const Faces& faces, idx f,
+                        order moved, const vec3d& position, double angle);
+  bool (*isElongated)(const vec3d& pos0, const vec3d& pos1, const vec3d& pos2,
+                      double ratio);
+  // false if the face is degenerate, see computeQuadrics()
+  bool (*planeQuadric)(const Vertices& vertices, const Faces& faces, idx f,
+                       const SimplifyOptions& options, Quadric& q);
+  bool (*borderQuadric)(const Vertices& vertices, const Faces& faces, idx f,
+                        order k, const SimplifyOptions& options, Quadric& q);
+  // see fanQuadric() and edgeQuadric()
+  Quadric (*fanQuadric)(const Vertices& vertices, const Faces& faces,
+                        const Edge& edge, idx v,
+                        const SimplifyOptions& options);
+  Quadric (*edgeQuadric)(const Vertices& vertices, const Faces& faces,
+                         const Edge& edge, const SimplifyOptions& options);
+  // sort by key, then by face
+  void (*sortHalfEdges)(HalfEdge* begin, HalfEdge* end);
+};
+
+// Kernels of the ISA level in use
+const Kernels& kernels();
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_KERNELS_HPP
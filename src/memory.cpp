@@ -0,0 +1,87 @@
+#include "memory.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+namespace MeshSimpl {
+
+namespace {
+
+class NewDeleteResource final : public MemoryResource {
+ public:
+  void* allocate(size_t bytes, size_t alignment) override {
+    // operator new is aligned for any fundamental type, which is all that
+    // internal arrays hold
+    assert(alignment <= alignof(std::max_align_t));
+    (void)alignment;
+    return ::operator new(bytes);
+  }
+
+  void deallocate(void* p, size_t, size_t) override { ::operator delete(p); }
+};
+
+thread_local MemoryResource* current = nullptr;
+
+}  // namespace
+
+MemoryResource* newDeleteResource() {
+  static NewDeleteResource resource;
+  return &resource;
+}
+
+MonotonicArena::MonotonicArena(size_t chunkBytes, MemoryResource* upstream)
+    : upstream(upstream),
+      firstChunkBytes(std::max(chunkBytes, sizeof(Chunk))),
+      nextChunkBytes(firstChunkBytes) {}
+
+void* MonotonicArena::allocate(size_t bytes, size_t alignment) {
+  uintptr_t at = (reinterpret_cast<uintptr_t>(begin) + alignment - 1) &
+                 ~(uintptr_t(alignment) - 1);
+  if (!chunk || at + bytes > reinterpret_cast<uintptr_t>(end)) {
+    // the chunk header is aligned for anything, see NewDeleteResource
+    const size_t chunkBytes =
+        std::max(nextChunkBytes, sizeof(Chunk) + bytes + alignment);
+    Chunk* taken = static_cast<Chunk*>(
+        upstream->allocate(chunkBytes, alignof(std::max_align_t)));
+    taken->prev = chunk;
+    taken->bytes = chunkBytes;
+    chunk = taken;
+    begin = reinterpret_cast<char*>(taken + 1);
+    end = reinterpret_cast<char*>(taken) + chunkBytes;
+    nextChunkBytes *= 2;
+    at = (reinterpret_cast<uintptr_t>(begin) + alignment - 1) &
+         ~(uintptr_t(alignment) - 1);
+  }
+  begin = reinterpret_cast<char*>(at + bytes);
+  _allocated += bytes;
+  return reinterpret_cast<void*>(at);
+}
+
+void MonotonicArena::release() {
+  while (chunk) {
+    Chunk* prev = chunk->prev;
+    upstream->deallocate(chunk, chunk->bytes, alignof(std::max_align_t));
+    chunk = prev;
+  }
+  begin = end = nullptr;
+  nextChunkBytes = firstChunkBytes;
+  _allocated = 0;
+}
+
+namespace Internal {
+
+MemoryResource* currentResource() {
+  return current ? current : newDeleteResource();
+}
+
+ResourceScope::ResourceScope(MemoryResource* resource) : previous(current) {
+  if (resource) current = resource;
+}
+
+ResourceScope::~ResourceScope() { current = previous; }
+
+}  // namespace Internal
+
+}  // namespace MeshSimpl
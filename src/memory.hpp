@@ -0,0 +1,129 @@
+#ifndef MESH_SIMPL_MEMORY_HPP
+#define MESH_SIMPL_MEMORY_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace MeshSimpl {
+
+// Source of memory for the internal arrays of a simplification, e.g., an
+// arena, huge pages or a resource accounting memory per job; modeled after
+// std::pmr::memory_resource
+class MemoryResource {
+ public:
+  virtual ~MemoryResource() = default;
+
+  virtual void* allocate(size_t bytes, size_t alignment) = 0;
+
+  virtual void deallocate(void* p, size_t bytes, size_t alignment) = 0;
+};
+
+// The resource of global operator new and delete, used by default
+MemoryResource* newDeleteResource();
+
+// Hands out memory from chunks taken from `upstream`, each twice as large as
+// the one before, and never frees it until release() or destruction: an
+// allocation only bumps a pointer, and the memory of a whole job is given
+// back at once. Not thread-safe
+class MonotonicArena final : public MemoryResource {
+ public:
+  explicit MonotonicArena(size_t chunkBytes = size_t(1) << 20,
+                          MemoryResource* upstream = newDeleteResource());
+  ~MonotonicArena() override { release(); }
+
+  MonotonicArena(const MonotonicArena&) = delete;
+  MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+  void* allocate(size_t bytes, size_t alignment) override;
+
+  void deallocate(void*, size_t, size_t) override {}
+
+  // Give all chunks back to upstream; memory handed out must no longer be
+  // in use
+  void release();
+
+  // Bytes handed out since construction or release()
+  size_t allocated() const { return _allocated; }
+
+ private:
+  struct Chunk {
+    Chunk* prev;
+    size_t bytes;
+  };
+
+  MemoryResource* upstream;
+  const size_t firstChunkBytes;
+  size_t nextChunkBytes;
+  Chunk* chunk = nullptr;  // the last chunk taken, first of a list
+  char* begin = nullptr;   // free space left in it
+  char* end = nullptr;
+  size_t _allocated = 0;
+};
+
+namespace Internal {
+
+// Resource that internal arrays created on this thread allocate from, set
+// by ResourceScope; newDeleteResource() if none is set
+MemoryResource* currentResource();
+
+// Make a resource current on this thread until destruction; null keeps the
+// current one. Scopes nest
+class ResourceScope {
+ public:
+  explicit ResourceScope(MemoryResource* resource);
+  ~ResourceScope();
+
+  ResourceScope(const ResourceScope&) = delete;
+  ResourceScope& operator=(const ResourceScope&) = delete;
+
+ private:
+  MemoryResource* previous;
+};
+
+// Allocator of the resource current when the allocator, i.e., usually its
+// container, was created. Containers keep it when moved, so they allocate
+// from the same resource throughout their life
+template <typename T>
+class Allocator {
+ public:
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  Allocator() : resource(currentResource()) {}
+
+  template <typename U>
+  Allocator(const Allocator<U>& other) : resource(other.resource) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    resource->deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  MemoryResource* resource;
+};
+
+template <typename T, typename U>
+bool operator==(const Allocator<T>& a, const Allocator<U>& b) {
+  return a.resource == b.resource;
+}
+
+template <typename T, typename U>
+bool operator!=(const Allocator<T>& a, const Allocator<U>& b) {
+  return a.resource != b.resource;
+}
+
+// An internal array, allocated from the current resource
+template <typename T>
+using Array = std::vector<T, Allocator<T>>;
+
+}  // namespace Internal
+
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_MEMORY_HPP
@@ -5,6 +5,8 @@
 #ifndef MESH_SIMPL_NEIGHBOR_HPP
 #define MESH_SIMPL_NEIGHBOR_HPP
 
+#include <initializer_list>
+
 #include "edge.hpp"
 #include "util.hpp"
 
@@ -84,6 +86,32 @@ class Neighbor {
   idx secondV() const { return faces[f()][_second]; }
 };
 
+// Call visit(nb) with a Neighbor of every face around vertex v of an edge,
+// starting from the wings of the edge
+template <typename Visit>
+void visitFan(const Vertices& vertices, const Faces& faces, const Edge* edge,
+              idx v, Visit visit) {
+  if (!vertices.isBoundary(v)) {
+    // traverse around like a fan
+    Neighbor nb(edge, 0, v, faces);
+    do {
+      visit(nb);
+      nb.rotate();
+    } while (nb.f() != edge->face(0));
+  } else {
+    // traverse with two rows stop at boundary
+    for (order column : {0, 1}) {
+      Neighbor nb(edge, column, v, faces);
+      visit(nb);
+      while (!nb.secondEdge()->onBoundary()) {
+        nb.rotate();
+        visit(nb);
+      }
+      if (edge->onBoundary()) break;
+    }
+  }
+}
+
 }  // namespace Internal
 }  // namespace MeshSimpl
 
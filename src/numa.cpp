@@ -0,0 +1,131 @@
+#include "numa.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace MeshSimpl {
+namespace Internal {
+
+// Parse a sysfs list such as "0-3,8,10-11"
+static std::vector<int> parseList(const std::string& str) {
+  std::vector<int> res;
+  std::stringstream ss(str);
+  for (std::string range; std::getline(ss, range, ',');) {
+    const size_t dash = range.find('-');
+    const int lo = std::stoi(range.substr(0, dash));
+    const int hi =
+        dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+    for (int i = lo; i <= hi; ++i) res.push_back(i);
+  }
+  return res;
+}
+
+NumaLayout::NumaLayout(const std::string& root) {
+  std::ifstream online(root + "online");
+  std::string line;
+  if (online >> line) {
+    for (int node : parseList(line)) {
+      std::ifstream cpulist(root + "node" + std::to_string(node) + "/cpulist");
+      std::string cpus;
+      cpulist >> cpus;
+      // memory-only nodes cannot run threads; leave them out
+      if (!cpus.empty()) _nodes.push_back({node, parseList(cpus)});
+    }
+  }
+  if (_nodes.empty()) _nodes.push_back({0, {}});
+}
+
+std::vector<unsigned long> NumaLayout::mask(
+    const std::vector<unsigned>& nodes) const {
+  const size_t bitsPerLong = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> res(1 + _nodes.back().id / bitsPerLong, 0);
+  for (unsigned n : nodes)
+    res[id(n) / bitsPerLong] |= 1UL << (id(n) % bitsPerLong);
+  return res;
+}
+
+#ifdef __linux__
+
+void NumaLayout::pinCurrentThread(unsigned node) const {
+  if (nodes() < 2) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : _nodes[node].cpus) CPU_SET(cpu, &set);
+  sched_setaffinity(0, sizeof(set), &set);
+}
+
+void NumaLayout::interleave(const void* data, size_t bytes) const {
+  if (nodes() < 2 || bytes == 0) return;
+  std::vector<unsigned> all;
+  for (unsigned n = 0; n < nodes(); ++n) all.push_back(n);
+  const char* begin = static_cast<const char*>(data);
+  bind(begin, begin + bytes, MPOL_INTERLEAVE, all);
+}
+
+void NumaLayout::partition(const void* data, size_t bytes,
+                           unsigned parts) const {
+  if (nodes() < 2 || bytes == 0) return;
+  const char* begin = static_cast<const char*>(data);
+  for (unsigned i = 0; i < parts; ++i) {
+    bind(begin + bytes * i / parts, begin + bytes * (i + 1) / parts, MPOL_BIND,
+         {nodeOf(i, parts)});
+  }
+}
+
+void NumaLayout::bind(const char* begin, const char* end, int mode,
+                      const std::vector<unsigned>& nodes) const {
+  // policies apply to whole pages: a page shared by two parts goes to the
+  // part holding its first byte
+  const uintptr_t page = sysconf(_SC_PAGESIZE);
+  const uintptr_t lo =
+      (reinterpret_cast<uintptr_t>(begin) + page - 1) & ~(page - 1);
+  const uintptr_t hi =
+      (reinterpret_cast<uintptr_t>(end) + page - 1) & ~(page - 1);
+  if (lo >= hi) return;
+
+  // mbind reads one bit less than maxnode; failure only leaves pages where
+  // they are
+  const std::vector<unsigned long> bits = mask(nodes);
+  syscall(SYS_mbind, lo, hi - lo, mode, bits.data(),
+          bits.size() * 8 * sizeof(unsigned long) + 1, MPOL_MF_MOVE);
+}
+
+AffinityGuard::AffinityGuard() : _mask(sizeof(cpu_set_t)) {
+  sched_getaffinity(0, _mask.size(),
+                    reinterpret_cast<cpu_set_t*>(_mask.data()));
+}
+
+AffinityGuard::~AffinityGuard() {
+  sched_setaffinity(0, _mask.size(),
+                    reinterpret_cast<cpu_set_t*>(_mask.data()));
+}
+
+#else
+
+void NumaLayout::pinCurrentThread(unsigned) const {}
+
+void NumaLayout::interleave(const void*, size_t) const {}
+
+void NumaLayout::partition(const void*, size_t, unsigned) const {}
+
+void NumaLayout::bind(const char*, const char*, int,
+                      const std::vector<unsigned>&) const {}
+
+AffinityGuard::AffinityGuard() {}
+
+AffinityGuard::~AffinityGuard() {}
+
+#endif
+
+}  // namespace Internal
+}  // namespace MeshSimpl
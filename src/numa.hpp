@@ -0,0 +1,88 @@
+#ifndef MESH_SIMPL_NUMA_HPP
+#define MESH_SIMPL_NUMA_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "types.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+// NUMA nodes of this machine and placement of memory and threads on them,
+// through the raw mbind and sched_setaffinity system calls so that libnuma is
+// not needed. On a single-node machine or outside Linux every placement is a
+// no-op.
+//
+// Only nodes with CPUs are used, numbered from 0 to nodes() - 1 in order of
+// their ids; id() gives the number the kernel knows a node by, which differs
+// once a memory-only node is left out.
+class NumaLayout {
+ public:
+  // Read nodes and their CPUs from sysfs, or from a directory laid out as
+  // /sys/devices/system/node/
+  explicit NumaLayout(const std::string& root = "/sys/devices/system/node/");
+
+  unsigned nodes() const { return _nodes.size(); }
+
+  // Kernel id of a node
+  int id(unsigned node) const { return _nodes[node].id; }
+
+  // Node of thread t out of `threads`; threads are assigned to nodes in
+  // contiguous groups, as are the blocks of ThreadPool::parallelForStatic()
+  unsigned nodeOf(unsigned t, unsigned threads) const {
+    return static_cast<unsigned long>(t) * nodes() / threads;
+  }
+
+  // Restrict the calling thread to the CPUs of a node
+  void pinCurrentThread(unsigned node) const;
+
+  // Spread pages of the range round-robin over all nodes
+  void interleave(const void* data, size_t bytes) const;
+
+  // Split the range into `parts` contiguous parts and move part i to node
+  // nodeOf(i, parts)
+  void partition(const void* data, size_t bytes, unsigned parts) const;
+
+  // Node mask of mbind and get_mempolicy holding the kernel ids of `nodes`
+  std::vector<unsigned long> mask(const std::vector<unsigned>& nodes) const;
+
+  template <class T, class A>
+  void place(const std::vector<T, A>& v, MemoryPlacement placement,
+             unsigned parts) const {
+    if (placement == MemoryPlacement::INTERLEAVED)
+      interleave(v.data(), v.size() * sizeof(T));
+    else if (placement == MemoryPlacement::PARTITIONED)
+      partition(v.data(), v.size() * sizeof(T), parts);
+  }
+
+ private:
+  struct Node {
+    int id;
+    std::vector<int> cpus;
+  };
+  std::vector<Node> _nodes;
+
+  // Bind pages covering [begin, end) with a memory policy and migrate them
+  void bind(const char* begin, const char* end, int mode,
+            const std::vector<unsigned>& nodes) const;
+};
+
+// Save the CPU affinity of the calling thread and restore it on destruction
+class AffinityGuard {
+ public:
+  AffinityGuard();
+  ~AffinityGuard();
+
+  AffinityGuard(const AffinityGuard&) = delete;
+  AffinityGuard& operator=(const AffinityGuard&) = delete;
+
+ private:
+  std::vector<unsigned char> _mask;
+};
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_NUMA_HPP
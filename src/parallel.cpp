@@ -0,0 +1,120 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace MeshSimpl {
+namespace Internal {
+
+ThreadPool::ThreadPool(unsigned threads) {
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  helpers.reserve(threads - 1);
+  errors.resize(threads);
+  for (unsigned t = 1; t < threads; ++t)
+    helpers.emplace_back(&ThreadPool::serve, this, t);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto& t : helpers) t.join();
+}
+
+void ThreadPool::runOnAll(const ThreadFn& fn) {
+  if (helpers.empty()) {
+    fn(0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job = &fn;
+    busy = helpers.size();
+    ++generation;
+  }
+  wake.notify_all();
+
+  try {
+    fn(0);
+  } catch (...) {
+    errors[0] = std::current_exception();
+  }
+
+  // helpers refer to fn until they are done, whether or not a call threw
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    job = nullptr;
+  }
+
+  for (std::exception_ptr& error : errors)
+    if (error) {
+      std::exception_ptr thrown = error;
+      for (std::exception_ptr& e : errors) e = nullptr;
+      std::rethrow_exception(thrown);
+    }
+}
+
+void ThreadPool::parallelFor(size_t n, size_t grain, const RangeFn& fn) {
+  if (grain == 0) grain = 1;
+  if (helpers.empty() || n <= grain) {
+    if (n > 0) fn(0, n);
+    return;
+  }
+
+  // the job refers to the chunks through a single pointer, which
+  // std::function stores without allocating
+  struct Chunks {
+    size_t n, grain, count;
+    const RangeFn* fn;
+    std::atomic<size_t> next;
+  } chunks;
+  chunks.n = n;
+  chunks.grain = grain;
+  chunks.count = (n + grain - 1) / grain;
+  chunks.fn = &fn;
+  chunks.next = 0;
+  Chunks* shared = &chunks;
+  runOnAll([shared](unsigned) {
+    for (size_t c = shared->next++; c < shared->count; c = shared->next++)
+      (*shared->fn)(c * shared->grain,
+                    std::min(shared->n, (c + 1) * shared->grain));
+  });
+}
+
+void ThreadPool::parallelForStatic(size_t n, const RangeFn& fn) {
+  runOnAll([&](unsigned t) {
+    const auto range = block(n, t);
+    if (range.first < range.second) fn(range.first, range.second);
+  });
+}
+
+void ThreadPool::serve(unsigned t) {
+  unsigned long seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&] { return stopping || generation != seen; });
+      if (stopping) return;
+      seen = generation;
+    }
+
+    try {
+      (*job)(t);
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --busy;
+    }
+    done.notify_one();
+  }
+}
+
+}  // namespace Internal
+}  // namespace MeshSimpl
@@ -0,0 +1,73 @@
+#ifndef MESH_SIMPL_PARALLEL_HPP
+#define MESH_SIMPL_PARALLEL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MeshSimpl {
+namespace Internal {
+
+// A fixed set of helper threads which, together with the calling thread, run
+// a range of independent work items. Threads are created once and sleep
+// between jobs so the pool can be reused for many small batches.
+//
+// Threads are numbered from 0, the calling thread, to size() - 1.
+class ThreadPool {
+ public:
+  typedef std::function<void(size_t, size_t)> RangeFn;
+  typedef std::function<void(unsigned)> ThreadFn;
+
+  // Create `threads - 1` helper threads; the caller is the last worker.
+  // Zero means one thread per hardware thread
+  explicit ThreadPool(unsigned threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Number of threads taking part in a job, including the caller
+  unsigned size() const { return helpers.size() + 1; }
+
+  // Call fn(t) once on every thread t and return when all calls returned.
+  // If calls threw, the exception of the lowest t is rethrown then
+  void runOnAll(const ThreadFn& fn);
+
+  // Call fn(begin, end) on disjoint chunks of at most `grain` items covering
+  // [0, n) and return when every chunk is done. Ranges no longer than `grain`
+  // run on the calling thread only, without waking the helpers
+  void parallelFor(size_t n, size_t grain, const RangeFn& fn);
+
+  // Call fn(begin, end) on thread t for the t-th of size() contiguous blocks
+  // of [0, n), so a block is always processed by the same thread
+  void parallelForStatic(size_t n, const RangeFn& fn);
+
+  // The block of [0, n) processed by thread t in parallelForStatic()
+  std::pair<size_t, size_t> block(size_t n, unsigned t) const {
+    return {n * t / size(), n * (t + 1) / size()};
+  }
+
+ private:
+  std::vector<std::thread> helpers;
+  std::mutex mutex;
+  std::condition_variable wake;  // signals helpers a new job or stopping
+  std::condition_variable done;  // signals caller a helper left the job
+
+  const ThreadFn* job = nullptr;
+  unsigned busy = 0;             // helpers still working on current job
+  unsigned long generation = 0;  // incremented for each job
+  bool stopping = false;
+  std::vector<std::exception_ptr> errors;  // thrown by the job on thread t
+
+  // Loop of helper thread t
+  void serve(unsigned t);
+};
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_PARALLEL_HPP
@@ -0,0 +1,289 @@
+#include "planar.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "proc.hpp"
+#include "util.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+static const idx NONE = std::numeric_limits<idx>::max();
+
+// a face joins a region if 1 - cos of the angle between its normal and the
+// normal of the region is at most NORMAL_TOLERANCE, and its corners are at
+// most PLANE_TOLERANCE times the bounding box diagonal off the plane
+static const double NORMAL_TOLERANCE = 1e-10;
+static const double PLANE_TOLERANCE = 1e-9;
+
+// longest boundary loop retriangulated; ear clipping is quadratic in it
+static const size_t MAX_LOOP = 4096;
+
+typedef std::array<double, 2> vec2d;
+
+// Hash of the key of an edge, which std::hash lacks for 128-bit keys
+struct KeyHash {
+  size_t operator()(HalfEdge::Key key) const {
+    const uint64_t v0 = static_cast<uint64_t>(key >> HalfEdge::IDX_BITS);
+    return std::hash<uint64_t>()(static_cast<uint64_t>(key) * 31 + v0);
+  }
+};
+
+// Twice the signed area of triangle abc, positive if counter-clockwise
+static double orient(const vec2d& a, const vec2d& b, const vec2d& c) {
+  return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+// Quality of triangle abc in (0, 1], 1 if equilateral; see isElongated()
+static double quality(const vec2d& a, const vec2d& b, const vec2d& c) {
+  const double ab = std::hypot(b[0] - a[0], b[1] - a[1]);
+  const double bc = std::hypot(c[0] - b[0], c[1] - b[1]);
+  const double ca = std::hypot(a[0] - c[0], a[1] - c[1]);
+  const double s = (ab + bc + ca) / 2;
+  return 8 * (s - ab) * (s - bc) * (s - ca) / (ab * bc * ca);
+}
+
+bool triangulatePolygon(const std::vector<vec2d>& polygon,
+                        std::vector<vec3i>& triangles) {
+  const idx n = polygon.size();
+  if (n < 3) return false;
+  std::vector<idx> prv(n), nxt(n);
+  for (idx i = 0; i < n; ++i) {
+    prv[i] = (i + n - 1) % n;
+    nxt[i] = (i + 1) % n;
+  }
+
+  // quality of the ear at each corner, or -1 if it is not one: the corner
+  // turns left and no other corner is in or on the ear
+  std::vector<double> ear(n);
+  const auto rate = [&](idx b) {
+    const vec2d &pa = polygon[prv[b]], &pb = polygon[b], &pc = polygon[nxt[b]];
+    ear[b] = -1;
+    if (orient(pa, pb, pc) <= 0) return;
+    for (idx p = nxt[nxt[b]]; p != prv[b]; p = nxt[p]) {
+      const vec2d& pp = polygon[p];
+      if (orient(pa, pb, pp) >= 0 && orient(pb, pc, pp) >= 0 &&
+          orient(pc, pa, pp) >= 0)
+        return;
+    }
+    ear[b] = quality(pa, pb, pc);
+  };
+  for (idx b = 0; b < n; ++b) rate(b);
+
+  // clip the best ear until a triangle is left; best rather than first keeps
+  // long runs of collinear corners from ending up in one fan of slivers
+  idx b = 0;
+  for (idx left = n; left > 3; --left) {
+    idx best = b;
+    for (idx c = nxt[b]; c != b; c = nxt[c])
+      if (ear[c] > ear[best]) best = c;
+    if (ear[best] < 0) return false;
+    triangles.push_back({prv[best], best, nxt[best]});
+    nxt[prv[best]] = nxt[best];
+    prv[nxt[best]] = prv[best];
+    b = nxt[best];
+    rate(prv[b]);
+    rate(b);
+  }
+  if (orient(polygon[prv[b]], polygon[b], polygon[nxt[b]]) <= 0) return false;
+  triangles.push_back({prv[b], b, nxt[b]});
+  return true;
+}
+
+size_t retriangulatePlanarRegions(const Positions& positions, Indices& indices,
+                                  const std::vector<bool>& fixed,
+                                  size_t nfMin) {
+  const size_t NF = indices.size();
+  if (NF == 0) return 0;
+
+  vec3d lo = positions[indices[0][0]], hi = lo;
+  for (const auto& pos : positions) {
+    for (int i = 0; i < 3; ++i) {
+      lo[i] = std::min(lo[i], pos[i]);
+      hi[i] = std::max(hi[i], pos[i]);
+    }
+  }
+  const double tolerance = PLANE_TOLERANCE * magnitude(hi - lo);
+
+  // unit normals, zero for degenerate faces
+  std::vector<vec3d> normals(NF);
+  for (idx f = 0; f < NF; ++f) {
+    const vec3i& face = indices[f];
+    vec3d normal = cross(positions[face[1]] - positions[face[0]],
+                         positions[face[2]] - positions[face[0]]);
+    const double area = magnitude(normal);
+    if (area != 0) normal /= area;
+    normals[f] = area != 0 ? normal : vec3d{0, 0, 0};
+  }
+
+  // the face across each side, NONE on boundary and non-manifold edges
+  const std::vector<HalfEdge> sides = sortedHalfEdges(indices);
+  std::vector<std::array<idx, 3>> across(NF, {{NONE, NONE, NONE}});
+  for (size_t i = 0, j; i < sides.size(); i = j) {
+    for (j = i + 1; j < sides.size() && sides[j].key == sides[i].key; ++j)
+      ;
+    if (j - i != 2) continue;
+    across[sides[i].f][sides[i].k] = sides[i + 1].f;
+    across[sides[i + 1].f][sides[i + 1].k] = sides[i].f;
+  }
+  std::vector<unsigned> valence(positions.size(), 0);
+  for (const auto& face : indices)
+    for (idx v : face) ++valence[v];
+
+  std::vector<idx> regionOf(NF, NONE);  // first face of region of a face
+  std::vector<vec3i> triangulated;      // new faces of all regions
+  std::vector<std::pair<size_t, size_t>> ranges;  // of a region in them
+  std::vector<idx> rangeOf(NF, NONE);             // by first face of region
+  // new edges
+  std::unordered_set<HalfEdge::Key, KeyHash> diagonals;
+  size_t nf = NF;
+
+  std::vector<idx> members, loop;
+  std::unordered_map<idx, idx> loopNext;
+  std::unordered_map<idx, unsigned> uses;
+  std::vector<vec2d> polygon;
+  std::vector<vec3i> triangles;
+
+  // try to retriangulate the region of faces `members` with first face r
+  const auto retriangulate = [&](idx r) -> bool {
+    // the boundary of a disk is a single loop, oriented as the faces, through
+    // distinct vertices
+    loopNext.clear();
+    uses.clear();
+    idx start = NONE;
+    for (idx g : members) {
+      for (order k = 0; k < 3; ++k) {
+        ++uses[indices[g][k]];
+        const idx h = across[g][k];
+        if (h != NONE && regionOf[h] == r) continue;
+        const idx v0 = indices[g][next(k)], v1 = indices[g][prev(k)];
+        if (!loopNext.emplace(v0, v1).second) return false;
+        if (start == NONE) start = v0;
+      }
+    }
+    if (loopNext.size() > MAX_LOOP) return false;
+    loop.clear();
+    for (idx v = start; loop.size() < loopNext.size();) {
+      loop.push_back(v);
+      const auto it = loopNext.find(v);
+      if (it == loopNext.end()) return false;
+      v = it->second;
+      if (v == start) break;
+    }
+    if (loop.size() != loopNext.size()) return false;
+
+    // interior vertices are removed; they must be movable and only used by
+    // the region
+    size_t interior = 0;
+    for (const auto& use : uses) {
+      if (loopNext.count(use.first)) continue;
+      if (!fixed.empty() && fixed[use.first]) return false;
+      if (use.second != valence[use.first]) return false;
+      ++interior;
+    }
+    // a disk with B boundary and I interior vertices has 2I + B - 2 faces
+    if (interior == 0 || members.size() != 2 * interior + loop.size() - 2)
+      return false;
+    if (nf - 2 * interior < nfMin) return false;
+
+    // project to the plane, axes (u, w, normal) being right-handed
+    const vec3d& n = normals[r];
+    int minor = 0;
+    for (int i = 1; i < 3; ++i)
+      if (std::abs(n[i]) < std::abs(n[minor])) minor = i;
+    vec3d axis = {0, 0, 0};
+    axis[minor] = 1;
+    vec3d u = cross(n, axis);
+    u /= magnitude(u);
+    const vec3d w = cross(n, u);
+    polygon.clear();
+    for (idx v : loop)
+      polygon.push_back({dot(positions[v], u), dot(positions[v], w)});
+
+    triangles.clear();
+    if (!triangulatePolygon(polygon, triangles)) return false;
+
+    // a diagonal must not be an edge already, unless inside the region
+    std::vector<HalfEdge::Key> added;
+    for (const auto& tri : triangles) {
+      for (order k = 0; k < 3; ++k) {
+        const idx i0 = tri[next(k)], i1 = tri[prev(k)];
+        if ((i0 + 1) % loop.size() == i1 || (i1 + 1) % loop.size() == i0)
+          continue;
+        const idx v0 = std::min(loop[i0], loop[i1]);
+        const idx v1 = std::max(loop[i0], loop[i1]);
+        const HalfEdge::Key key = HalfEdge::makeKey(v0, v1);
+        if (diagonals.count(key)) return false;
+        auto it = std::lower_bound(
+            sides.begin(), sides.end(), key,
+            [](const HalfEdge& side, HalfEdge::Key k) {
+              return side.key < k;
+            });
+        for (; it != sides.end() && it->key == key; ++it)
+          if (regionOf[it->f] != r) return false;
+        added.push_back(key);
+      }
+    }
+
+    diagonals.insert(added.begin(), added.end());
+    rangeOf[r] = ranges.size();
+    ranges.emplace_back(triangulated.size(),
+                        triangulated.size() + triangles.size());
+    for (const auto& tri : triangles)
+      triangulated.push_back({loop[tri[0]], loop[tri[1]], loop[tri[2]]});
+    nf -= 2 * interior;
+    return true;
+  };
+
+  // grow regions of coplanar faces from each face not in one yet, comparing
+  // with the plane of the first face so that regions cannot bend
+  std::vector<char> removed(NF, 0);
+  for (idx r = 0; r < NF; ++r) {
+    if (regionOf[r] != NONE || normals[r] == vec3d{0, 0, 0}) continue;
+    const vec3d& n = normals[r];
+    const double d = -dot(n, positions[indices[r][0]]);
+
+    members.assign(1, r);
+    regionOf[r] = r;
+    for (size_t m = 0; m < members.size(); ++m) {
+      for (idx h : across[members[m]]) {
+        if (h == NONE || regionOf[h] != NONE) continue;
+        if (dot(normals[h], n) < 1 - NORMAL_TOLERANCE) continue;
+        bool inPlane = true;
+        for (idx v : indices[h])
+          inPlane = inPlane && std::abs(dot(n, positions[v]) + d) <= tolerance;
+        if (!inPlane) continue;
+        regionOf[h] = r;
+        members.push_back(h);
+      }
+    }
+
+    if (members.size() >= 3 && retriangulate(r))
+      for (idx g : members) removed[g] = 1;
+  }
+
+  // replace each region where its first face was
+  Indices result;
+  result.reserve(nf);
+  for (idx f = 0; f < NF; ++f) {
+    if (!removed[f]) {
+      result.push_back(indices[f]);
+    } else if (rangeOf[f] != NONE) {
+      const auto& range = ranges[rangeOf[f]];
+      result.insert(result.end(), triangulated.begin() + range.first,
+                    triangulated.begin() + range.second);
+    }
+  }
+  indices.swap(result);
+  return NF - nf;
+}
+
+}  // namespace Internal
+}  // namespace MeshSimpl
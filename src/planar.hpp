@@ -0,0 +1,32 @@
+#ifndef MESH_SIMPL_PLANAR_HPP
+#define MESH_SIMPL_PLANAR_HPP
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "types.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+// Triangulate a simple polygon, given by 2D points in counter-clockwise
+// order, by ear clipping into triangles of point indices in the same order.
+// Returns false if no ear is found, e.g., the polygon is not simple
+bool triangulatePolygon(const std::vector<std::array<double, 2>>& polygon,
+                        std::vector<vec3i>& triangles);
+
+// Replace every connected region of coplanar faces that is a disk with the
+// triangulation of its boundary loop, i.e., remove its interior vertices
+// without moving anything. Regions with fixed interior vertices, and those
+// whose new edges would duplicate an edge of the mesh, are kept; so are
+// regions that would bring the face count below `nfMin`. Removed vertices
+// stay in positions, unreferenced. Returns the number of removed faces
+size_t retriangulatePlanarRegions(const Positions& positions, Indices& indices,
+                                  const std::vector<bool>& fixed,
+                                  size_t nfMin);
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_PLANAR_HPP
@@ -2,16 +2,17 @@
 // Created by nickl on 1/8/19.
 //
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <initializer_list>
-#include <map>
 #include <sstream>
 #include <stdexcept>
 #include <utility>
 
 #include "edge.hpp"
 #include "faces.hpp"
+#include "kernels.hpp"
 #include "proc.hpp"
 #include "quadric.hpp"
 #include "util.hpp"
@@ -21,59 +22,53 @@ namespace MeshSimpl {
 namespace Internal {
 
 void computeQuadrics(Vertices &vertices, const Faces &faces,
-                     const SimplifyOptions &options) {
-  for (idx f = 0; f < faces.size(); ++f) {
-    // calculate the plane of this face (n and d: n'v+d=0 defines the plane)
-    const vec3d edgeVec2 = faces.edgeVec(f, 2, vertices);
-    const vec3d edgeVec1 = faces.edgeVec(f, 1, vertices);
-    vec3d normal = cross(edgeVec2, edgeVec1);
-    // |normal| = area, used for normalization and weighting quadrics
-    const double area = magnitude(normal);
-    if (area != 0)
-      normal /= area;
+                     const SimplifyOptions &options, bool facePlanes) {
+  // quadrics rounded when set are summed in double and set once
+  Array<Quadric> sums;
+  if (vertices.roundsQuadrics()) {
+    sums.resize(vertices.size());
+    for (idx v = 0; v < vertices.size(); ++v) sums[v] = vertices.q(v);
+  }
+  const auto increaseQ = [&](idx v, const Quadric &by) {
+    if (sums.empty())
+      vertices.increaseQ(v, by);
     else
-      continue;
-
-    // d = -n*v0
-    const double d = -dot(normal, faces.vPos(f, 0, vertices));
-
-    // calculate quadric Q = (A, b, c) = (nn', dn, d*d)
-    Quadric q(normal, d);
-    if (options.weightByArea) q *= area;
+      sums[v] += by;
+  };
 
-    for (order k : {0, 1, 2}) vertices.increaseQ(faces.v(f, k), q);
+  Quadric q;
+  for (idx f = 0; facePlanes && f < faces.size(); ++f) {
+    if (!kernels().planeQuadric(vertices, faces, f, options, q)) continue;
+    for (order k : {0, 1, 2}) increaseQ(faces.v(f, k), q);
   }
 
   // compute constraints for boundaries unless they are always fixed
-  if (!options.fixedVertices.empty() || !options.fixBoundary) {
+  if (constrainsBorders(options)) {
     for (idx f = 0; f < faces.size(); ++f) {
       if (!faces.onBoundary(f)) continue;
 
-      const std::array<vec3d, 3> e{faces.edgeVec(f, 0, vertices),
-                                   faces.edgeVec(f, 1, vertices),
-                                   faces.edgeVec(f, 2, vertices)};
-      const vec3d nFace = cross(e[0], e[1]);
-
       for (order k : {0, 1, 2}) {
         if (!faces.side(f, k)->onBoundary()) continue;
-
-        vec3d normal = cross(nFace, e[k]);
-        const double normalMag = magnitude(normal);
-        if (normalMag != 0)
-          normal /= normalMag;
-        else
+        if (!kernels().borderQuadric(vertices, faces, f, k, options, q))
           continue;
 
-        const double d = -dot(normal, faces.vPos(f, next(k), vertices));
-        Quadric q(normal, d);
-        q *= options.borderConstraint;
-        if (options.weightByArea) q *= magnitude(nFace);
-
-        vertices.increaseQ(faces.v(f, next(k)), q);
-        vertices.increaseQ(faces.v(f, prev(k)), q);
+        increaseQ(faces.v(f, next(k)), q);
+        increaseQ(faces.v(f, prev(k)), q);
       }
     }
   }
+
+  for (idx v = 0; v < sums.size(); ++v) vertices.setQ(v, sums[v]);
+}
+
+Quadric fanQuadric(const Vertices &vertices, const Faces &faces,
+                   const Edge &edge, idx v, const SimplifyOptions &options) {
+  return kernels().fanQuadric(vertices, faces, edge, v, options);
+}
+
+Quadric edgeQuadric(const Vertices &vertices, const Faces &faces,
+                    const Edge &edge, const SimplifyOptions &options) {
+  return kernels().edgeQuadric(vertices, faces, edge, options);
 }
 
 bool edgeTopoCorrectness(const Faces &faces, const Edges &edges) {
@@ -93,60 +88,78 @@ bool edgeTopoCorrectness(const Faces &faces, const Edges &edges) {
   return true;
 }
 
+std::vector<HalfEdge> sortedHalfEdges(const Indices &indices) {
+  std::vector<HalfEdge> halfEdges;
+  halfEdges.reserve(indices.size() * 3);
+  for (idx f = 0; f < indices.size(); ++f) {
+    for (order k = 0; k < 3; ++k) {
+      idx v0 = indices[f][next(k)];
+      idx v1 = indices[f][prev(k)];
+      if (v0 > v1) std::swap(v0, v1);
+      halfEdges.push_back({HalfEdge::makeKey(v0, v1), f, k});
+    }
+  }
+  kernels().sortHalfEdges(halfEdges.data(),
+                          halfEdges.data() + halfEdges.size());
+  return halfEdges;
+}
+
 void buildConnectivity(Vertices &vertices, Faces &faces, Edges &edges) {
-  std::map<std::pair<idx, idx>, std::pair<Edge, bool>> edgeSet;
+  Array<HalfEdge> halfEdges;
+  buildConnectivity(vertices, faces, edges, halfEdges);
+}
 
-  // insert all edges into edgeSet and find out if it is on boundary
+void buildConnectivity(Vertices &vertices, Faces &faces, Edges &edges,
+                       Array<HalfEdge> &halfEdges) {
+  // list all sides of faces; after sorting, sides of the same edge are
+  // adjacent and ordered by face
+  halfEdges.clear();
+  halfEdges.reserve(faces.size() * 3);
   for (idx f = 0; f < faces.size(); ++f) {
     const auto &face = faces[f];
     for (order k = 0; k < 3; ++k) {
       // construct edge (v[i], v[j]);
       // edge local index will be k (= that of the 3rd vertex)
-      const order i = next(k);
-      const order j = prev(k);
-      idx v0 = face[i];
-      idx v1 = face[j];
+      idx v0 = face[next(k)];
+      idx v1 = face[prev(k)];
       if (v0 > v1) std::swap(v0, v1);
-      auto res = edgeSet.emplace(std::make_pair(v0, v1),
-                                 std::make_pair(Edge(vertices, v0, v1), false));
-      auto inserted = res.second;
-      auto &edge = res.first->second.first;
-      auto &twoWings = res.first->second.second;
-
-      if (inserted) {
-        edge.setWing(0, f, k);
-        assert(!twoWings);
-      } else {
-        if (twoWings) {
-          std::stringstream ss;
-          ss << "ERROR::INPUT_MESH: found non-manifold edge" << std::endl;
-          for (idx _f : {edge.face(0), edge.face(1), f}) {
-            ss << "                   face #" << _f << ":";
-            for (int _i = 0; _i < 3; ++_i) ss << "\t" << faces[_f][_i] + 1;
-            ss << std::endl;
-          }
-          throw std::invalid_argument(ss.str());
-        } else {
-          edge.setWing(1, f, k);
-          twoWings = true;
-        }
-      }
+      halfEdges.push_back({HalfEdge::makeKey(v0, v1), f, k});
     }
   }
+  kernels().sortHalfEdges(halfEdges.data(),
+                          halfEdges.data() + halfEdges.size());
+
+  size_t edgeCount = 0;
+  for (size_t i = 0; i < halfEdges.size(); ++i)
+    if (i == 0 || halfEdges[i].key != halfEdges[i - 1].key) ++edgeCount;
+
+  // populate edges vector from groups of sides with the same endpoints
+  edges.reserve(edgeCount);
+  for (size_t i = 0, j; i < halfEdges.size(); i = j) {
+    const HalfEdge::Key key = halfEdges[i].key;
+    for (j = i + 1; j < halfEdges.size() && halfEdges[j].key == key; ++j)
+      ;
+
+    if (j - i > 2) {
+      std::stringstream ss;
+      ss << "ERROR::INPUT_MESH: found non-manifold edge" << std::endl;
+      for (size_t h = i; h < i + 3; ++h) {
+        const idx _f = halfEdges[h].f;
+        ss << "                   face #" << _f << ":";
+        for (int _i = 0; _i < 3; ++_i) ss << "\t" << faces[_f][_i] + 1;
+        ss << std::endl;
+      }
+      throw std::invalid_argument(ss.str());
+    }
 
-  // populate edges vector from map
-  edges.reserve(edgeSet.size());
-  for (const auto &elem : edgeSet) {
-    auto &edge = elem.second.first;
-    auto &twoWings = elem.second.second;
-
-    edges.emplace_back(edge);
-
-    faces.setSide(edge.face(0), edge.ordInF(0), &edges.back());
-    if (!twoWings) {
-      for (order i : {0, 1}) vertices.setBoundary(edge.endpoint(i), true);
-    } else {
-      faces.setSide(edge.face(1), edge.ordInF(1), &edges.back());
+    edges.emplace_back(vertices, halfEdges[i].v0(), halfEdges[i].v1());
+    Edge &edge = edges.back();
+    for (size_t h = i; h < j; ++h) {
+      edge.setWing(h - i, halfEdges[h].f, halfEdges[h].k);
+      faces.setSide(halfEdges[h].f, halfEdges[h].k, &edge);
+    }
+    if (j - i == 1) {
+      for (order e : {0, 1}) vertices.setBoundary(edge.endpoint(e), true);
     }
   }
 
@@ -155,39 +168,12 @@ void buildConnectivity(Vertices &vertices, Faces &faces, Edges &edges) {
 
 bool isFaceFlipped(const Vertices &vertices, const Faces &faces, idx f,
                    order moved, const vec3d &position, double angle) {
-  const vec3d &vk = faces.vPos(f, moved, vertices);
-  const vec3d &vi = faces.vPos(f, next(moved), vertices);
-  const vec3d &vj = faces.vPos(f, prev(moved), vertices);
-  const vec3d edgeVec0 = vj - vi;
-  const vec3d edgeVec1 = vk - vj;
-  const vec3d edgeVec1New = position - vj;
-  vec3d normalPrv = cross(edgeVec0, edgeVec1);
-  double magPrv = magnitude(normalPrv);
-  if (magPrv != 0) {
-    vec3d normalNew = cross(edgeVec0, edgeVec1New);
-    double magNew = magnitude(normalNew);
-    if (magNew == 0) return true;
-    normalPrv /= magPrv;
-    normalNew /= magNew;
-    double cos = dot(normalPrv, normalNew);
-    return cos < angle;
-  } else {
-    return false;
-  }
+  return kernels().isFaceFlipped(vertices, faces, f, moved, position, angle);
 }
 
 bool isElongated(const vec3d &pos0, const vec3d &pos1, const vec3d &pos2,
                  double ratio) {
-  assert(ratio > 0.0);
-  const vec3d vec01 = pos1 - pos0;
-  const vec3d vec02 = pos2 - pos0;
-  const vec3d vec12 = pos2 - pos1;
-  const double a = magnitude(vec01);
-  const double b = magnitude(vec12);
-  const double c = magnitude(vec02);
-  const double s = (a + b + c) / 2.0;
-  const double aspectRatioRecip = 8 * (s - a) * (s - b) * (s - c) / (a * b * c);
-  return aspectRatioRecip < ratio;
+  return kernels().isElongated(pos0, pos1, pos2, ratio);
 }
 
 }  // namespace Internal
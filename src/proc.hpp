@@ -1,6 +1,10 @@
 #ifndef MESH_SIMPL_PROC_HPP
 #define MESH_SIMPL_PROC_HPP
 
+#include <vector>
+
+#include "kernels.hpp"
+#include "quadric.hpp"
 #include "types.hpp"
 
 namespace MeshSimpl {
@@ -9,12 +13,27 @@ namespace Internal {
 class Faces;
 class Vertices;
 
-// Compute quadrics Q for every vertex
+// Compute quadrics Q for every vertex; without facePlanes, only boundary
+// constraints are added to the quadrics already there
 void computeQuadrics(Vertices& vertices, const Faces& faces,
-                     const SimplifyOptions& options);
+                     const SimplifyOptions& options, bool facePlanes = true);
+
+// Quadric of endpoint v of an edge made of the faces around v as they are
+// now, i.e., what computeQuadrics() would give on the current mesh
+Quadric fanQuadric(const Vertices& vertices, const Faces& faces,
+                   const Edge& edge, idx v, const SimplifyOptions& options);
+
+// Quadric minimized by a collapse of the edge: the sum of quadrics of its
+// endpoints, from fanQuadric() if memoryless
+Quadric edgeQuadric(const Vertices& vertices, const Faces& faces,
+                    const Edge& edge, const SimplifyOptions& options);
 
 bool edgeTopoCorrectness(const Faces& faces, const Edges& edges);
 
+// Sides of faces, sorted so that sides of the same edge are adjacent and
+// ordered by face
+std::vector<HalfEdge> sortedHalfEdges(const Indices& indices);
+
 // Build connectivity, namely creating edges, assign sides to faces, set
 // vertices boundary or not. This allows traversal on the mesh via:
 //  * Faces::side()
@@ -24,6 +43,10 @@ bool edgeTopoCorrectness(const Faces& faces, const Edges& edges);
 //  * Edge::ordInF()
 void buildConnectivity(Vertices& vertices, Faces& faces, Edges& edges);
 
+// Build connectivity with `halfEdges` as scratch space, to reuse its storage
+void buildConnectivity(Vertices& vertices, Faces& faces, Edges& edges,
+                       Array<HalfEdge>& halfEdges);
+
 // Returns true if the movement of vertex will cause this face to flip too much
 bool isFaceFlipped(const Vertices& vertices, const Faces& faces, idx f,
                    order moved, const vec3d& position, double angle);
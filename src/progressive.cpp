@@ -0,0 +1,230 @@
+#include "progressive.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace MeshSimpl {
+
+// "MSPL", version 1
+static const char MAGIC[4] = {'M', 'S', 'P', 'L'};
+static const uint32_t VERSION = 1;
+
+// Values are written as they are in memory, field by field so that padding
+// is left out
+template <typename T>
+static void put(std::ostream& os, const T& value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static void get(std::istream& is, T& value) {
+  if (!is.read(reinterpret_cast<char*>(&value), sizeof(T)))
+    throw std::runtime_error("ERROR::INPUT_LOG: log is truncated");
+}
+
+// Read `size` values, growing the array as they arrive so that a corrupt
+// size runs into the end of the stream rather than a huge allocation
+template <typename T, typename Read>
+static void readArray(std::vector<T>& array, uint64_t size, Read read) {
+  static const uint64_t RESERVE = 1 << 16;
+  array.clear();
+  array.reserve(std::min(size, RESERVE));
+  for (uint64_t i = 0; i < size; ++i) {
+    T value;
+    read(value);
+    array.push_back(value);
+  }
+}
+
+// bytes of a split, a corner and a fork in the stream
+static const size_t SPLIT_BYTES = 6 * sizeof(idx) + 2 * sizeof(vec3d);
+static const size_t CORNER_BYTES = 3 * sizeof(idx) + sizeof(order);
+static const size_t FORK_BYTES = 2 * sizeof(idx);
+
+size_t CollapseLog::bytes() const {
+  return sizeof(MAGIC) + 2 * sizeof(uint32_t) + 7 * sizeof(uint64_t) +
+         splits.size() * SPLIT_BYTES + positions.size() * sizeof(vec3d) +
+         faces.size() * sizeof(vec3i) + corners.size() * CORNER_BYTES +
+         forks.size() * FORK_BYTES;
+}
+
+void CollapseLog::write(std::ostream& os) const {
+  os.write(MAGIC, sizeof(MAGIC));
+  put(os, VERSION);
+  put(os, static_cast<uint32_t>(sizeof(idx)));
+  put(os, static_cast<uint64_t>(baseVertices));
+  put(os, static_cast<uint64_t>(baseFaces));
+  put(os, static_cast<uint64_t>(splits.size()));
+  put(os, static_cast<uint64_t>(positions.size()));
+  put(os, static_cast<uint64_t>(faces.size()));
+  put(os, static_cast<uint64_t>(corners.size()));
+  put(os, static_cast<uint64_t>(forks.size()));
+  for (const Split& split : splits) {
+    put(os, split.kept);
+    put(os, split.deleted);
+    put(os, split.keptPosition);
+    put(os, split.center);
+    put(os, split.vertexEnd);
+    put(os, split.faceEnd);
+    put(os, split.cornerEnd);
+    put(os, split.forkEnd);
+  }
+  for (const vec3d& position : positions) put(os, position);
+  for (const vec3i& face : faces) put(os, face);
+  for (const Corner& corner : corners) {
+    put(os, corner.face);
+    put(os, corner.coarse);
+    put(os, corner.fine);
+    put(os, corner.k);
+  }
+  for (const auto& fork : forks) put(os, fork);
+}
+
+void CollapseLog::read(std::istream& is) {
+  char magic[sizeof(MAGIC)];
+  uint32_t version, idxBytes;
+  if (!is.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+    throw std::runtime_error("ERROR::INPUT_LOG: not a collapse log");
+  get(is, version);
+  get(is, idxBytes);
+  if (version != VERSION || idxBytes != sizeof(idx))
+    throw std::runtime_error(
+        "ERROR::INPUT_LOG: log of another version or index type");
+
+  uint64_t sizes[7];
+  for (uint64_t& size : sizes) get(is, size);
+  baseVertices = sizes[0];
+  baseFaces = sizes[1];
+  readArray(splits, sizes[2], [&](Split& split) {
+    get(is, split.kept);
+    get(is, split.deleted);
+    get(is, split.keptPosition);
+    get(is, split.center);
+    get(is, split.vertexEnd);
+    get(is, split.faceEnd);
+    get(is, split.cornerEnd);
+    get(is, split.forkEnd);
+  });
+  readArray(positions, sizes[3], [&](vec3d& position) {
+    get(is, position);
+  });
+  readArray(faces, sizes[4], [&](vec3i& face) { get(is, face); });
+  readArray(corners, sizes[5], [&](Corner& corner) {
+    get(is, corner.face);
+    get(is, corner.coarse);
+    get(is, corner.fine);
+    get(is, corner.k);
+  });
+  readArray(forks, sizes[6],
+            [&](std::array<idx, 2>& fork) { get(is, fork); });
+  validate();
+}
+
+void CollapseLog::validate() const {
+  const auto fail = [] {
+    throw std::runtime_error("ERROR::INPUT_LOG: log is corrupt");
+  };
+  // numbers of vertices and faces of the input, without overflowing
+  const size_t MAX = std::numeric_limits<idx>::max();
+  if (positions.size() > MAX || baseVertices > MAX - positions.size() ||
+      faces.size() > MAX || baseFaces > MAX - faces.size())
+    fail();
+  const size_t nv = baseVertices + positions.size();
+  const size_t nf = baseFaces + faces.size();
+
+  idx vertexBegin = 0, faceBegin = 0, cornerBegin = 0, forkBegin = 0;
+  for (const Split& split : splits) {
+    if (split.kept >= nv || split.deleted >= nv ||
+        split.vertexEnd < vertexBegin || split.faceEnd < faceBegin ||
+        split.cornerEnd < cornerBegin || split.forkEnd < forkBegin)
+      fail();
+    vertexBegin = split.vertexEnd;
+    faceBegin = split.faceEnd;
+    cornerBegin = split.cornerEnd;
+    forkBegin = split.forkEnd;
+  }
+  if (vertexBegin > positions.size() || faceBegin > faces.size() ||
+      cornerBegin > corners.size() || forkBegin > forks.size())
+    fail();
+
+  for (const vec3i& face : faces)
+    for (idx v : face)
+      if (v >= nv) fail();
+  for (const Corner& corner : corners)
+    if (corner.face >= nf || corner.coarse >= nv || corner.fine >= nv ||
+        corner.k < 0 || corner.k >= 3)
+      fail();
+  for (const auto& fork : forks)
+    if (fork[0] >= nv || fork[1] >= nv) fail();
+}
+
+ProgressiveMesh::ProgressiveMesh(const Positions& positions,
+                                 const Indices& indices,
+                                 const CollapseLog& log)
+    : log(log) {
+  if (positions.size() != log.baseVertices ||
+      indices.size() != log.baseFaces)
+    throw std::invalid_argument(
+        "ERROR::INPUT_MESH: base mesh is not the one of the log");
+
+  // vertices and faces of all levels, each as it is when it comes back
+  _positions.reserve(positions.size() + log.positions.size());
+  _positions.assign(positions.begin(), positions.end());
+  _positions.insert(_positions.end(), log.positions.begin(),
+                    log.positions.end());
+  _indices.reserve(indices.size() + log.faces.size());
+  _indices.assign(indices.begin(), indices.end());
+  _indices.insert(_indices.end(), log.faces.begin(), log.faces.end());
+}
+
+size_t ProgressiveMesh::refine(size_t count) {
+  count = std::min(count, levels() - _level);
+  for (size_t s = _level; s < _level + count; ++s) {
+    const CollapseLog::Split& split = log.splits[s];
+    _positions[split.kept] = split.keptPosition;
+    const size_t begin = s > 0 ? log.splits[s - 1].cornerEnd : 0;
+    for (size_t i = split.cornerEnd; i-- > begin;) {
+      const CollapseLog::Corner& corner = log.corners[i];
+      _indices[corner.face][corner.k] = corner.fine;
+    }
+  }
+  _level += count;
+  return count;
+}
+
+size_t ProgressiveMesh::coarsen(size_t count) {
+  count = std::min(count, _level);
+  for (size_t s = _level; s-- > _level - count;) {
+    const CollapseLog::Split& split = log.splits[s];
+    _positions[split.kept] = split.center;
+    const size_t begin = s > 0 ? log.splits[s - 1].cornerEnd : 0;
+    for (size_t i = begin; i < split.cornerEnd; ++i) {
+      const CollapseLog::Corner& corner = log.corners[i];
+      _indices[corner.face][corner.k] = corner.coarse;
+    }
+  }
+  _level -= count;
+  return count;
+}
+
+void ProgressiveMesh::setLevel(size_t level) {
+  if (level > _level)
+    refine(level - _level);
+  else
+    coarsen(_level - level);
+}
+
+size_t ProgressiveMesh::vertexCount() const {
+  return log.baseVertices +
+         (_level > 0 ? log.splits[_level - 1].vertexEnd : 0);
+}
+
+size_t ProgressiveMesh::faceCount() const {
+  return log.baseFaces + (_level > 0 ? log.splits[_level - 1].faceEnd : 0);
+}
+
+}  // namespace MeshSimpl
@@ -0,0 +1,103 @@
+#ifndef MESH_SIMPL_PROGRESSIVE_HPP
+#define MESH_SIMPL_PROGRESSIVE_HPP
+
+#include <array>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "types.hpp"
+
+namespace MeshSimpl {
+
+// The collapses of simplify(), written if SimplifyOptions::collapseLog is
+// set, as vertex splits that refine its result, the base mesh, back into its
+// input. Vertices and faces brought back are numbered after those of the
+// base mesh in order of their splits, so the mesh at any level takes a
+// prefix of them, see ProgressiveMesh
+struct CollapseLog {
+  // Undoes a collapse: `deleted` comes back and `kept` moves from `center`
+  // back to `keptPosition`
+  struct Split {
+    idx kept, deleted;
+    vec3d keptPosition, center;
+    // ends of the ranges of this split in the arrays below; the ranges of a
+    // split begin where those of the one before end
+    idx vertexEnd, faceEnd, cornerEnd, forkEnd;
+  };
+
+  // A corner of a face that refers to `coarse` before the split and to `fine`
+  // after it. Corners of a split are in the order of the collapse: they are
+  // set to `fine` last to first to refine, and to `coarse` first to last to
+  // coarsen
+  struct Corner {
+    idx face;
+    idx coarse, fine;
+    order k;
+  };
+
+  size_t baseVertices = 0, baseFaces = 0;
+  std::vector<Split> splits;  // from coarse to fine
+  Positions positions;        // of vertices brought back by the splits
+  Indices faces;              // of faces brought back, as they come back
+  std::vector<Corner> corners;
+  // vertices split off by the collapse to keep the mesh manifold, each with
+  // the vertex it was split from; they are unreferenced after the split
+  std::vector<std::array<idx, 2>> forks;
+
+  // Bytes of write()
+  size_t bytes() const;
+
+  // Write in a compact binary format, or read what was written; reading
+  // throws if the stream does not hold a valid log of this build's index
+  // type
+  void write(std::ostream& os) const;
+  void read(std::istream& is);
+
+  // Throw if a split, face, corner or fork refers outside the log or the
+  // ranges of the splits are out of order, as in a corrupt file
+  void validate() const;
+};
+
+// A mesh refined and coarsened one split at a time between the base mesh of
+// a CollapseLog and the input of its simplification, e.g., for continuous
+// levels of detail or progressive transmission. At every level the mesh is
+// the first vertexCount() positions and faceCount() indices, so only the
+// changed corners and the new tail need an upload. Vertices split off
+// to keep the mesh manifold stay in the prefix, unreferenced
+class ProgressiveMesh {
+ public:
+  // Start at the base mesh, the output of the simplify() that wrote `log`,
+  // which must outlive this
+  ProgressiveMesh(const Positions& positions, const Indices& indices,
+                  const CollapseLog& log);
+
+  // Number of splits applied, from 0 at the base mesh to levels() at the
+  // input
+  size_t level() const { return _level; }
+  size_t levels() const { return log.splits.size(); }
+
+  // Apply the next `count` splits or undo the last `count`, as many as there
+  // are; returns the number applied or undone
+  size_t refine(size_t count = 1);
+  size_t coarsen(size_t count = 1);
+
+  // Refine or coarsen to a level
+  void setLevel(size_t level);
+
+  size_t vertexCount() const;
+  size_t faceCount() const;
+  const Positions& positions() const { return _positions; }
+  const Indices& indices() const { return _indices; }
+
+ private:
+  const CollapseLog& log;
+  Positions _positions;
+  Indices _indices;
+  size_t _level = 0;
+};
+
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_PROGRESSIVE_HPP
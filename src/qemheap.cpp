@@ -13,16 +13,16 @@
 namespace MeshSimpl {
 namespace Internal {
 
-QEMHeap::QEMHeap(Edges &edges)
-    : keys(edges.size() + 1),
-      edges(edges),
-      handles(edges.size(), 0),
-      n(0),
-      removed(edges.size(), false) {
+QEMHeap::QEMHeap(Edges &edges) : edges(edges), n(0) { reset(); }
+
+void QEMHeap::reset() {
+  keys.resize(edges.size() + 1);
+  handles.assign(edges.size(), 0);
+  removed.assign(edges.size(), false);
+  n = 0;
   for (idx e = 0; e < edges.size(); ++e) {
     keys[handles[e] = ++n] = e;
   }
-  keys.resize(n + 1);
 }
 
 void QEMHeap::pop() {
@@ -55,7 +55,11 @@ void QEMHeap::markRemovedById(idx e) { removed[e] = true; }
 bool QEMHeap::greater(size_t i, size_t j) const {
   assert(!std::isnan(edges[keys[i]].error()));
   assert(!std::isnan(edges[keys[j]].error()));
-  return edges[keys[i]].error() > edges[keys[j]].error();
+  const double ei = edges[keys[i]].error();
+  const double ej = edges[keys[j]].error();
+  // break ties on edge id so the selected edge depends on the errors only and
+  // not on the history of heap operations
+  return ei > ej || (ei == ej && keys[i] > keys[j]);
 }
 
 void QEMHeap::exchange(size_t i, size_t j) {
@@ -10,59 +10,65 @@
 #include <vector>
 
 #include "edge.hpp"
+#include "edgequeue.hpp"
 #include "types.hpp"
 
 namespace MeshSimpl {
 namespace Internal {
 
 // Reference: https://algs4.cs.princeton.edu/24pq/MinPQ.java
-class QEMHeap {
+class QEMHeap final : public EdgeQueue {
  public:
   // Construct a min-binary-heap with edge ecol errors as keys;
   // store a reference of the list of edges and store all handles
   explicit QEMHeap(Edges &edges);
 
-  void prioritize() {
+  void reset() override;
+
+  void prioritize() override {
     for (size_t k = n / 2; k >= 1; --k) sink(k);
     assert(isMinHeap());
   }
 
   // Returns the edge id with minimum ecol error in heap. It is possible that
   // the output is an erased edge or it has been removed from heap
-  Edge *top() const { return &edges[keys[1]]; }
+  Edge *top() override { return empty() ? nullptr : &edges[keys[1]]; }
 
   // Remove the top edge from heap
-  void pop();
+  void pop() override;
 
   // Fix the priority of an edge after the error value is modified;
   // Param `errorPrev` is used to determine the direction of priority change
-  void fix(const Edge *edge, double errorPrev);
+  void fix(const Edge *edge, double errorPrev) override;
 
   // Suppress this edge until it is, if ever, updated next time
-  void penalize(Edge *edge);
+  void penalize(Edge *edge) override;
 
   // Returns true if heap is empty
-  bool empty() const { return size() == 0; }
+  bool empty() const override { return size() == 0; }
 
   // Returns the size of the heap
   size_t size() const { return n; };
 
   // Returns true if the edge exists in heap and is not marked as removed
-  bool contains(const Edge *edge) const;
+  bool contains(const Edge *edge) const override;
 
   // Mark removed but does not touch actual heap data
-  void markRemoved(const Edge *edge);
+  void markRemoved(const Edge *edge) override;
   void markRemovedById(idx e);
-  void unmarkRemoved(const Edge *edge) { removed[id(edge)] = false; }
+  void unmarkRemoved(const Edge *edge) override {
+    removed[id(edge)] = false;
+  }
 
  private:
-  std::vector<idx> keys;        // binary heap array, indexed from 1
-  Edges &edges;                 // a reference to `edges`
-  std::vector<size_t> handles;  // handles[e] is the position of e in keys
-  size_t n;                     // = heap.size() = keys.size() - 1
-  std::vector<bool> removed;    // erased from heap
-
-  // Compare function: larger error --> lower priority
+  Array<idx> keys;        // binary heap array, indexed from 1
+  Edges &edges;           // a reference to `edges`
+  Array<size_t> handles;  // handles[e] is the position of e in keys
+  size_t n;               // = heap.size() = keys.size() - 1
+  Array<bool> removed;    // erased from heap
+
+  // Compare function: larger error --> lower priority; equal errors are
+  // ordered by edge id which makes the order of edges total
   bool greater(size_t i, size_t j) const;
 
   // Helper function: the sole function that modifies handles and keys data
@@ -61,6 +61,34 @@ class Quadric {
     return {center, err};
   }
 
+  // The quadric of the same error at `pos + by` as this at `pos`, i.e.,
+  // this in coordinates relative to `by`
+  Quadric translated(const vec3d& by) const {
+    const vec3d aBy{dot({_value[0], _value[1], _value[2]}, by),
+                    dot({_value[1], _value[3], _value[4]}, by),
+                    dot({_value[2], _value[4], _value[5]}, by)};
+    const vec3d b{_value[6], _value[7], _value[8]};
+    Quadric res = *this;
+    for (int i = 0; i < 3; ++i) res._value[6 + i] += aBy[i];
+    res._value[9] += dot(aBy, by) + dot(b, by) * 2;
+    return res;
+  }
+
+  // Coefficients rounded to float, storing a quadric in half the memory.
+  // Rounding is relative to the largest terms, so a quadric should be
+  // compacted relative to a point near its vertex, see translated()
+  typedef std::array<float, 10> Compact;
+
+  explicit Quadric(const Compact& compact) {
+    for (int i = 0; i < 10; ++i) _value[i] = compact[i];
+  }
+
+  Compact compact() const {
+    Compact compact;
+    for (int i = 0; i < 10; ++i) compact[i] = static_cast<float>(_value[i]);
+    return compact;
+  }
+
   Quadric& operator+=(const Quadric& q) {
     for (auto i = 0; i < _value.size(); ++i) _value[i] += q._value[i];
     return *this;
@@ -0,0 +1,220 @@
+#include "simplification.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "bucketqueue.hpp"
+#include "edgesampler.hpp"
+#include "numa.hpp"
+#include "proc.hpp"
+#include "qemheap.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+// edges planned by one thread in a single chunk when building the heap
+static const size_t PLAN_GRAIN = 4096;
+
+// seed of random draws of edges when options.candidates is set
+static const uint64_t SAMPLER_SEED = 0x5eed;
+
+// finest bucket of errors when options.bucketWidth is set, 2^-MAX_BUCKET_BITS
+static const unsigned MAX_BUCKET_BITS = 10;
+
+constexpr double Simplification::NO_COLLAPSE;
+
+// Bits of the mantissa shared by errors in a bucket no wider than `width`
+static unsigned bucketBits(float width) {
+  const double bits = std::ceil(-std::log2(width));
+  return static_cast<unsigned>(
+      std::min(std::max(bits, 0.0), static_cast<double>(MAX_BUCKET_BITS)));
+}
+
+Simplification::Simplification(Positions& positions, Indices& indices,
+                               const SimplifyOptions& options,
+                               ThreadPool& pool,
+                               const std::vector<Quadric>* quadrics)
+    : options(options),
+      pool(pool),
+      quadrics(quadrics),
+      vertices(positions, !options.memoryless),
+      faces(indices),
+      nf(faces.size()) {}
+
+Simplification::Simplification(PositionsF& positions, Indices& indices,
+                               const SimplifyOptions& options,
+                               ThreadPool& pool)
+    : options(options),
+      pool(pool),
+      quadrics(nullptr),
+      vertices(positions, !options.memoryless),
+      faces(indices),
+      nf(faces.size()) {}
+
+Simplification::Simplification(const VertexBuffer& buffer, size_t stride,
+                               Indices& indices,
+                               const SimplifyOptions& options,
+                               ThreadPool& pool)
+    : options(options),
+      pool(pool),
+      quadrics(nullptr),
+      vertices(buffer, stride, !options.memoryless),
+      faces(indices),
+      nf(faces.size()) {}
+
+void Simplification::reset(const Positions& positions,
+                           const Indices& indices) {
+  vertices.reset(positions);
+  faces.reset(indices);
+  edges.clear();
+  nf = faces.size();
+}
+
+void Simplification::prepare(ThreadPool& planPool, const Connect& connect) {
+  // find out information of edges (endpoints, incident faces) and face2edge
+  if (connect)
+    connect(vertices, faces, edges);
+  else
+    buildConnectivity(vertices, faces, edges, halfEdges);
+
+  // determine each vertex should be fixed or not
+  if (options.fixedVertices.empty()) {
+    if (options.fixBoundary)
+      for (idx v = 0; v < vertices.size(); ++v)
+        vertices.setFixed(v, vertices.isBoundary(v));
+  } else {
+    for (idx v = 0; v < vertices.size(); ++v)
+      vertices.setFixed(v, options.fixedVertices[v]);
+  }
+
+  // compute quadrics of vertices
+  if (!options.memoryless) {
+    if (quadrics)
+      for (idx v = 0; v < vertices.size(); ++v)
+        vertices.setQ(v, (*quadrics)[v]);
+    computeQuadrics(vertices, faces, options, quadrics == nullptr);
+  }
+
+  // assigning edge errors using quadrics; captures only `this`, which a
+  // std::function stores without allocating
+  planned.resize(edges.size());
+  const auto plan = [this](size_t b, size_t e) {
+    for (size_t i = b; i < e; ++i)
+      planned[i] = edges[i].planCollapse(
+          edgeQuadric(vertices, faces, edges[i], options),
+          options.keepVertices);
+  };
+  if (options.placement == MemoryPlacement::FIRST_TOUCH) {
+    planPool.parallelFor(edges.size(), PLAN_GRAIN, plan);
+  } else {
+    // pin threads and place arrays on NUMA nodes. edges are sorted by their
+    // smaller endpoint, so the t-th block of edges mostly refers to the t-th
+    // block of vertices and both end up on the node of thread t
+    AffinityGuard affinity;
+    const NumaLayout numa;
+    const unsigned parts = planPool.size();
+    planPool.runOnAll(
+        [&](unsigned t) { numa.pinCurrentThread(numa.nodeOf(t, parts)); });
+    vertices.place(numa, options.placement, parts);
+    faces.place(numa, options.placement, parts);
+    numa.place(edges, options.placement, parts);
+
+    if (options.placement == MemoryPlacement::PARTITIONED)
+      planPool.parallelForStatic(edges.size(), plan);
+    else
+      planPool.parallelFor(edges.size(), PLAN_GRAIN, plan);
+  }
+
+  // the queue and the collapser of a mesh before are reused
+  if (queue)
+    queue->reset();
+  else if (options.candidates > 0)
+    queue.reset(new EdgeSampler(edges, options.candidates, SAMPLER_SEED));
+  else if (options.bucketWidth > 0)
+    queue.reset(new BucketQueue(edges, bucketBits(options.bucketWidth)));
+  else
+    queue.reset(new QEMHeap(edges));
+  for (size_t e = 0; e < edges.size(); ++e) {
+    if (!planned[e]) {
+      queue->markRemoved(&edges[e]);
+    }
+  }
+  queue->prioritize();
+
+  if (!collapser)
+    collapser.reset(new Collapser(vertices, faces, *queue, pool, options));
+  trace.clear();
+  collapser->setTrace(log ? &trace : nullptr);
+}
+
+double Simplification::nextError() {
+  while (!queue->empty()) {
+    // skip edges erased or removed from queue since they were pushed. when
+    // the least error is infinity, all remaining edges have been penalized
+    const Edge* edge = queue->top();
+    if (!edge) break;
+    if (!edge->exists() || !queue->contains(edge)) {
+      queue->pop();
+      continue;
+    }
+    return edge->error();
+  }
+  return NO_COLLAPSE;
+}
+
+int Simplification::collapseNext() {
+  // collapse the least-error edge
+  const int removed = collapser->collapse(queue->top());
+  nf -= removed;
+  return removed;
+}
+
+void Simplification::collapseTo(size_t nfTarget) {
+  while (nf > nfTarget && nextError() < NO_COLLAPSE) collapseNext();
+}
+
+MeshSize Simplification::outputSize() {
+  vertices.eraseUnref(faces);
+  MeshSize size;
+  size.vertices = vertices.count();
+  size.faces = nf;
+  return size;
+}
+
+void Simplification::write(vec3d* positions, vec3i* indices,
+                           std::vector<idx>& renumbered, idx* origins) {
+  vertices.eraseUnref(faces);
+  vertices.writeCompacted(renumbered, positions, origins);
+  faces.writeCompacted(renumbered, indices);
+}
+
+void Simplification::finish(Positions& positions, Indices& indices,
+                            std::vector<idx>* origins) {
+  vertices.eraseUnref(faces);
+  if (log) trace.write(vertices, faces, *log);
+
+  // edges are useless
+  // faces and vertices will be used to generate indices and positions
+  // then they are useless as well
+  faces.compactIndicesAndDie(indices);
+  vertices.compactPositionsAndDie(positions, indices, origins);
+}
+
+void Simplification::finish(PositionsF& positions, Indices& indices,
+                            std::vector<idx>* origins) {
+  vertices.eraseUnref(faces);
+  if (log) trace.write(vertices, faces, *log);
+  faces.compactIndicesAndDie(indices);
+  vertices.compactPositionsAndDie(positions, indices, origins);
+}
+
+size_t Simplification::finish(Indices& indices) {
+  vertices.eraseUnref(faces);
+  if (log) trace.write(vertices, faces, *log);
+  faces.compactIndicesAndDie(indices);
+  return vertices.compactRecordsAndDie(indices);
+}
+
+}  // namespace Internal
+}  // namespace MeshSimpl
@@ -0,0 +1,130 @@
+#ifndef MESH_SIMPL_SIMPLIFICATION_HPP
+#define MESH_SIMPL_SIMPLIFICATION_HPP
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "collapser.hpp"
+#include "edge.hpp"
+#include "edgequeue.hpp"
+#include "faces.hpp"
+#include "parallel.hpp"
+#include "proc.hpp"
+#include "progressive.hpp"
+#include "quadric.hpp"
+#include "trace.hpp"
+#include "types.hpp"
+#include "vertices.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+// The state of simplifying one mesh: its connectivity, quadrics and the queue
+// of edges, advanced one collapse at a time. simplify() runs a single one to
+// its target; several can be interleaved to share a budget.
+class Simplification {
+ public:
+  // Embed the mesh; positions and indices are moved and no longer hold data.
+  // Collapses re-plan dirty edges on `pool`. If `quadrics` is given, they
+  // replace the face quadrics of the vertices, e.g., to keep the error of a
+  // mesh simplified before; it must outlive prepare()
+  Simplification(Positions& positions, Indices& indices,
+                 const SimplifyOptions& options, ThreadPool& pool,
+                 const std::vector<Quadric>* quadrics = nullptr);
+
+  // Embed a mesh of single precision positions, see Vertices
+  Simplification(PositionsF& positions, Indices& indices,
+                 const SimplifyOptions& options, ThreadPool& pool);
+
+  // Embed a mesh whose positions stay in the records of a vertex buffer,
+  // see Vertices; finish() writes the result back into them
+  Simplification(const VertexBuffer& buffer, size_t stride, Indices& indices,
+                 const SimplifyOptions& options, ThreadPool& pool);
+
+  // Embed another mesh, copied into the storage of the one before, which
+  // is dropped; prepare() is to be called again. Simplifying many meshes one
+  // after the other this way stops allocating once their size stops growing
+  void reset(const Positions& positions, const Indices& indices);
+
+  // Builds edges, wings, sides and boundary flags, see buildConnectivity()
+  typedef std::function<void(Vertices&, Faces&, Edges&)> Connect;
+
+  // Build connectivity with `connect`, by default buildConnectivity(), and
+  // quadrics, plan all edges on `planPool` and build the queue. Must be
+  // called before anything else, once per mesh
+  void prepare(ThreadPool& planPool, const Connect& connect = Connect());
+
+  // Track which vertex of the input each vertex stands for, see finish().
+  // Must be called before prepare()
+  void trackOrigins() { vertices.trackOrigins(); }
+
+  // Record accepted collapses and write them to `log` in finish(), see
+  // CollapseLog. Must be called before prepare()
+  void logCollapses(CollapseLog& log) { this->log = &log; }
+
+  // Number of faces in the mesh now
+  size_t faceCount() const { return nf; }
+
+  // Error of the next collapse, or NO_COLLAPSE if no edge can be collapsed
+  double nextError();
+
+  // Try to collapse the edge of nextError(); returns the number of removed
+  // faces, which is 0 if the collapse was rejected
+  int collapseNext();
+
+  // Collapse the least-error edge until at most `nfTarget` faces are left or
+  // no edge can be collapsed
+  void collapseTo(size_t nfTarget);
+
+  // Write the simplified mesh; nothing else can be called afterwards. If
+  // origins are tracked, `origins` receives for each vertex the input vertex
+  // it stands for: itself, or a fixed vertex whose place it took. Vertices
+  // split to fix the topology stand for the same input vertex
+  void finish(Positions& positions, Indices& indices,
+              std::vector<idx>* origins = nullptr);
+  void finish(PositionsF& positions, Indices& indices,
+              std::vector<idx>* origins = nullptr);
+
+  // Write the simplified mesh embedded from a vertex buffer into the front of
+  // its records, see Vertices::compactRecordsAndDie(), and `indices`;
+  // returns the number of vertices. Origins must be tracked
+  size_t finish(Indices& indices);
+
+  // Size of the simplified mesh, to make room for write(). Collapses can
+  // continue afterwards
+  MeshSize outputSize();
+
+  // Write the simplified mesh into room for outputSize() vertices and faces
+  // without allocating it, in the order of finish(). `origins` is written
+  // if given, which needs origins to be tracked; `renumbered` is scratch
+  // space of the vertex count
+  void write(vec3d* positions, vec3i* indices, std::vector<idx>& renumbered,
+             idx* origins = nullptr);
+
+  static constexpr double NO_COLLAPSE = std::numeric_limits<double>::max();
+
+ private:
+  const SimplifyOptions& options;
+  ThreadPool& pool;
+  const std::vector<Quadric>* quadrics;
+  Vertices vertices;
+  Faces faces;
+  Edges edges;
+  std::unique_ptr<EdgeQueue> queue;
+  std::unique_ptr<Collapser> collapser;
+  size_t nf;
+  CollapseTrace trace;
+  CollapseLog* log = nullptr;
+
+  // scratch space of prepare(), kept to reuse its storage
+  Array<HalfEdge> halfEdges;
+  Array<char> planned;
+};
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_SIMPLIFICATION_HPP
@@ -0,0 +1,58 @@
+#include "simplifier.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "parallel.hpp"
+#include "simplification.hpp"
+#include "simplify.hpp"
+
+namespace MeshSimpl {
+
+using namespace Internal;
+
+Simplifier::Simplifier(const SimplifyOptions& options)
+    : options(options), pool(new ThreadPool(options.threads)) {
+  if (options.clusterFactor > 1 || options.planarRegions)
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: clusterFactor and planarRegions cannot be "
+        "used with a Simplifier");
+  shrink();
+}
+
+Simplifier::~Simplifier() = default;
+
+MeshSize Simplifier::simplify(const Positions& positions,
+                              const Indices& indices) {
+  validateOptions(options, positions.size());
+  const ResourceScope scope(options.memoryResource);
+  simplified = false;
+  simplification->reset(positions, indices);
+
+  const size_t NF = indices.size();
+  const size_t nfToDecimate = std::lround(options.strength * NF);
+  if (nfToDecimate > 0) {
+    simplification->prepare(*pool);
+    simplification->collapseTo(NF - nfToDecimate);
+  }
+  simplified = true;
+  return simplification->outputSize();
+}
+
+void Simplifier::write(vec3d* positions, vec3i* indices) {
+  if (!simplified)
+    throw std::runtime_error("ERROR::SIMPLIFIER: nothing was simplified");
+  simplification->write(positions, indices, renumbered);
+}
+
+void Simplifier::shrink() {
+  const ResourceScope scope(options.memoryResource);
+  Positions positions;
+  Indices indices;
+  simplification.reset();
+  simplification.reset(new Simplification(positions, indices, options, *pool));
+  simplified = false;
+  std::vector<idx>().swap(renumbered);
+}
+
+}  // namespace MeshSimpl
@@ -0,0 +1,52 @@
+#ifndef MESH_SIMPL_SIMPLIFIER_HPP
+#define MESH_SIMPL_SIMPLIFIER_HPP
+
+#include <memory>
+#include <vector>
+
+#include "types.hpp"
+
+namespace MeshSimpl {
+
+namespace Internal {
+class Simplification;
+class ThreadPool;
+}  // namespace Internal
+
+// Simplify by edge collapse as simplify() in two steps, so that the result is
+// written into memory owned by the caller, e.g., a mapped upload buffer or an
+// arena: simplify() leaves the result in the simplifier and returns its size,
+// and write() copies it out without allocating it. The simplifier keeps its
+// threads and the storage of vertices, faces, edges and the queue from one
+// mesh to the next, so simplifying many meshes of similar size allocates
+// nothing once the largest was seen. clusterFactor and planarRegions are not
+// supported
+class Simplifier {
+ public:
+  explicit Simplifier(const SimplifyOptions& options = {});
+  ~Simplifier();
+
+  // Simplify a mesh, which is not modified, and return the size of the
+  // result. Options apply as in simplify(); the result of an earlier call is
+  // dropped
+  MeshSize simplify(const Positions& positions, const Indices& indices);
+
+  // Write the result of the last simplify() into room for its size, in the
+  // same order as simplify() would
+  void write(vec3d* positions, vec3i* indices);
+
+  // Free the storage kept for the next mesh, e.g., after an unusually large
+  // one; the result of the last simplify() is dropped
+  void shrink();
+
+ private:
+  const SimplifyOptions options;
+  std::unique_ptr<Internal::ThreadPool> pool;
+  std::unique_ptr<Internal::Simplification> simplification;
+  bool simplified = false;
+  std::vector<idx> renumbered;
+};
+
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_SIMPLIFIER_HPP
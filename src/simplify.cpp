@@ -4,106 +4,483 @@
 
 #include "simplify.hpp"
 
+#include <array>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <queue>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
-#include "collapser.hpp"
-#include "edge.hpp"
-#include "faces.hpp"
-#include "proc.hpp"
-#include "qemheap.hpp"
-#include "vertices.hpp"
+#include "cluster.hpp"
+#include "components.hpp"
+#include "grid.hpp"
+#include "parallel.hpp"
+#include "planar.hpp"
+#include "simplification.hpp"
 
 namespace MeshSimpl {
 
 using namespace Internal;
 
 namespace Internal {
-void validateOptions(const SimplifyOptions &options,
-                     const Positions &positions) {
+void validateOptions(const SimplifyOptions &options, size_t vertexCount) {
   // clang-format off
   if (options.strength > 1)
     throw std::invalid_argument("ERROR::INVALID_OPTION: strength > 1");
   if (options.strength < 0)
     throw std::invalid_argument("ERROR::INVALID_OPTION: strength < 0");
+  if (options.bucketWidth < 0)
+    throw std::invalid_argument("ERROR::INVALID_OPTION: bucket width < 0");
   if (options.borderConstraint < 0)
     throw std::invalid_argument("ERROR::INVALID_OPTION: border constraint < 0");
   if (options.foldOverAngleThreshold > 1 || options.foldOverAngleThreshold < -1)
     throw std::invalid_argument("ERROR::INVALID_OPTION: fold-over angle not between -1 and 1");
   if (options.aspectRatioThreshold > 1.0)
     throw std::invalid_argument("ERROR::INVALID_OPTION: aspect-ratio-threshold cannot exceed 1");
-  if (!options.fixedVertices.empty() && options.fixedVertices.size() != positions.size())
+  if (!options.fixedVertices.empty() && options.fixedVertices.size() != vertexCount)
     throw std::invalid_argument("ERROR::INVALID_OPTION: fixedVertices is neither empty nor equal with 'positions' in size");
+  if (options.clusterFactor > 1 && !options.fixedVertices.empty())
+    throw std::invalid_argument("ERROR::INVALID_OPTION: fixedVertices cannot be used with clustering");
   // clang-format on
 }
 }  // namespace Internal
 
+// Write a log of no collapses if one is asked for, the input being the result
+static void logNoCollapse(CollapseLog *log, size_t nv, size_t nf) {
+  if (!log) return;
+  *log = CollapseLog();
+  log->baseVertices = nv;
+  log->baseFaces = nf;
+}
+
+// estimated bytes per face taken by edge collapse: vertices with quadrics,
+// faces, edges and the queue of edges
+static const size_t COLLAPSE_FACE_BYTES = 256;
+
 void simplify(Positions &positions, Indices &indices,
               const SimplifyOptions &options) {
-  validateOptions(options, positions);
+  validateOptions(options, positions.size());
+  const ResourceScope scope(options.memoryResource);
 
   const size_t NF = indices.size();
   const size_t nfToDecimate = std::lround(options.strength * NF);
 
-  if (nfToDecimate == 0) return;
+  if (nfToDecimate == 0) {
+    logNoCollapse(options.collapseLog, positions.size(), NF);
+    return;
+  }
+  const size_t nfTarget = NF - nfToDecimate;
+
+  // remove the interior of flat regions before anything else, it is exact
+  if (options.planarRegions)
+    retriangulatePlanarRegions(positions, indices, options.fixedVertices,
+                               nfTarget);
+
+  // cluster first if the reduction is heavy enough
+  std::vector<Quadric> quadrics;
+  const double nfClustered =
+      static_cast<double>(nfTarget) * options.clusterFactor;
+  if (options.clusterFactor > 1 && nfClustered < indices.size())
+    clusterToFaceCount(positions, indices, std::lround(nfClustered), nfTarget,
+                       options, quadrics);
 
   // construct vertices and faces from positions and indices
   // positions and indices are moved and no longer hold data
-  Vertices vertices(positions);
-  Faces faces(indices);
-
-  // find out information of edges (endpoints, incident faces) and face2edge
-  Edges edges;
-  buildConnectivity(vertices, faces, edges);
-
-  // determine each vertex should be fixed or not
-  if (options.fixedVertices.empty()) {
-    if (options.fixBoundary)
-      for (idx v = 0; v < vertices.size(); ++v)
-        vertices.setFixed(v, vertices.isBoundary(v));
-  } else {
-    for (idx v = 0; v < vertices.size(); ++v)
-      vertices.setFixed(v, options.fixedVertices[v]);
+  ThreadPool pool(options.threads);
+  Simplification simplification(positions, indices, options, pool,
+                                quadrics.empty() ? nullptr : &quadrics);
+  if (options.collapseLog) simplification.logCollapses(*options.collapseLog);
+  simplification.prepare(pool);
+
+  simplification.collapseTo(nfTarget);
+  simplification.finish(positions, indices);
+}
+
+void simplify(PositionsF &positions, Indices &indices,
+              const SimplifyOptions &options) {
+  validateOptions(options, positions.size());
+  if (options.clusterFactor > 1 || options.planarRegions)
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: clusterFactor and planarRegions need double "
+        "positions");
+  const ResourceScope scope(options.memoryResource);
+
+  const size_t NF = indices.size();
+  const size_t nfToDecimate = std::lround(options.strength * NF);
+  if (nfToDecimate == 0) {
+    logNoCollapse(options.collapseLog, positions.size(), NF);
+    return;
+  }
+
+  ThreadPool pool(options.threads);
+  Simplification simplification(positions, indices, options, pool);
+  if (options.collapseLog) simplification.logCollapses(*options.collapseLog);
+  simplification.prepare(pool);
+
+  simplification.collapseTo(NF - nfToDecimate);
+  simplification.finish(positions, indices);
+}
+
+// Read `faceCount` faces of indices of type I, checking that they are in the
+// vertex buffer
+template <typename I>
+static Indices readIndices(const I *indices, size_t faceCount,
+                           size_t vertexCount) {
+  Indices faces(faceCount);
+  for (size_t f = 0; f < faceCount; ++f)
+    for (order k = 0; k < 3; ++k) {
+      const I v = indices[3 * f + k];
+      if (v >= vertexCount)
+        throw std::invalid_argument(
+            "ERROR::INPUT_MESH: index out of the vertex buffer");
+      faces[f][k] = static_cast<idx>(v);
+    }
+  return faces;
+}
+
+// Simplify with positions read and written in the vertex buffer; each output
+// vertex takes the record of the input vertex it stands for
+template <typename I>
+static MeshSize simplifyBuffers(const VertexBuffer &buffer, size_t stride,
+                                I *indices, size_t faceCount, size_t nfTarget,
+                                const SimplifyOptions &options) {
+  Indices faces = readIndices(indices, faceCount, buffer.count);
+
+  ThreadPool pool(options.threads);
+  Simplification simplification(buffer, stride, faces, options, pool);
+  simplification.trackOrigins();
+  simplification.prepare(pool);
+  simplification.collapseTo(nfTarget);
+
+  MeshSize size = simplification.outputSize();
+  if (size.vertices > buffer.count)
+    throw std::runtime_error(
+        "ERROR::OUTPUT_MESH: more vertices than the vertex buffer holds");
+  if (size.vertices > 0 &&
+      size.vertices - 1 > std::numeric_limits<I>::max())
+    throw std::runtime_error(
+        "ERROR::OUTPUT_MESH: more vertices than the index type can address");
+  simplification.finish(faces);
+  for (size_t f = 0; f < faces.size(); ++f)
+    for (order k = 0; k < 3; ++k)
+      indices[3 * f + k] = static_cast<I>(faces[f][k]);
+  return size;
+}
+
+template <typename I>
+MeshSize simplify(const VertexBuffer &vertices, I *indices, size_t faceCount,
+                  const SimplifyOptions &options) {
+  validateOptions(options, vertices.count);
+  if (options.clusterFactor > 1 || options.planarRegions)
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: clusterFactor and planarRegions cannot be "
+        "used with a vertex buffer");
+  if (vertices.count > std::numeric_limits<idx>::max() ||
+      faceCount > std::numeric_limits<idx>::max())
+    throw std::invalid_argument(
+        "ERROR::INPUT_MESH: mesh too large for the index type of the library, "
+        "see MESH_SIMPL_64BIT_INDEX");
+  const size_t positionBytes =
+      vertices.doublePrecision ? sizeof(vec3d) : sizeof(vec3f);
+  const size_t stride = vertices.stride > 0 ? vertices.stride : positionBytes;
+  if (stride < positionBytes)
+    throw std::invalid_argument(
+        "ERROR::INPUT_MESH: vertex buffer stride is less than a position");
+
+  const size_t nfToDecimate = std::lround(options.strength * faceCount);
+  if (nfToDecimate == 0) {
+    MeshSize size;
+    size.vertices = vertices.count;
+    size.faces = faceCount;
+    return size;
+  }
+
+  const size_t nfTarget = faceCount - nfToDecimate;
+  const ResourceScope scope(options.memoryResource);
+  return simplifyBuffers(vertices, stride, indices, faceCount, nfTarget,
+                         options);
+}
+
+template MeshSize simplify(const VertexBuffer &, uint16_t *, size_t,
+                           const SimplifyOptions &);
+template MeshSize simplify(const VertexBuffer &, uint32_t *, size_t,
+                           const SimplifyOptions &);
+template MeshSize simplify(const VertexBuffer &, uint64_t *, size_t,
+                           const SimplifyOptions &);
+
+// Simplify a copy of the positions with vertices kept and return the faces of
+// the result in terms of the input vertices
+template <typename P>
+static Indices simplifyIndexOnly(const P &positions, const Indices &indices,
+                                 const SimplifyOptions &options) {
+  validateOptions(options, positions.size());
+  if (options.clusterFactor > 1 || options.planarRegions)
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: clusterFactor and planarRegions move vertices "
+        "and cannot be used with simplifyIndices()");
+  const size_t NF = indices.size();
+  const size_t nfToDecimate = std::lround(options.strength * NF);
+  if (nfToDecimate == 0) return indices;
+
+  const ResourceScope scope(options.memoryResource);
+  SimplifyOptions keptOptions = options;
+  keptOptions.keepVertices = true;
+  P kept = positions;
+  Indices faces = indices;
+  ThreadPool pool(options.threads);
+  Simplification simplification(kept, faces, keptOptions, pool);
+  simplification.trackOrigins();
+  simplification.prepare(pool);
+
+  simplification.collapseTo(NF - nfToDecimate);
+  std::vector<idx> origins;
+  simplification.finish(kept, faces, &origins);
+  for (auto &face : faces)
+    for (idx &v : face) v = origins[v];
+  return faces;
+}
+
+Indices simplifyIndices(const Positions &positions, const Indices &indices,
+                        const SimplifyOptions &options) {
+  return simplifyIndexOnly(positions, indices, options);
+}
+
+Indices simplifyIndices(const PositionsF &positions, const Indices &indices,
+                        const SimplifyOptions &options) {
+  return simplifyIndexOnly(positions, indices, options);
+}
+
+std::vector<Mesh> simplifyLods(const Positions &positions,
+                               const Indices &indices,
+                               const std::vector<LodTarget> &targets,
+                               const SimplifyOptions &options) {
+  validateOptions(options, positions.size());
+  if (options.clusterFactor > 1 || options.planarRegions)
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: clusterFactor and planarRegions cannot be "
+        "used with simplifyLods()");
+  for (size_t l = 0; l < targets.size(); ++l) {
+    if (targets[l].strength < 0 || targets[l].strength > 1)
+      throw std::invalid_argument(
+          "ERROR::INVALID_OPTION: LOD strength not between 0 and 1");
+    if (l > 0 && (targets[l].strength < targets[l - 1].strength ||
+                  targets[l].maxError < targets[l - 1].maxError))
+      throw std::invalid_argument(
+          "ERROR::INVALID_OPTION: LOD targets not ordered from fine to coarse");
   }
 
-  // compute quadrics of vertices
-  computeQuadrics(vertices, faces, options);
+  const ResourceScope scope(options.memoryResource);
+  Positions current = positions;
+  Indices faces = indices;
+  const size_t NF = faces.size();
+  ThreadPool pool(options.threads);
+  Simplification simplification(current, faces, options, pool);
+  if (options.keepVertices) simplification.trackOrigins();
+  simplification.prepare(pool);
 
-  // assigning edge errors using quadrics
-  QEMHeap heap(edges);
-  for (size_t e = 0; e < edges.size(); ++e) {
-    if (!edges[e].planCollapse()) {
-      heap.markRemovedById(e);
+  std::vector<Mesh> lods(targets.size());
+  std::vector<idx> renumbered, origins;
+  for (size_t l = 0; l < targets.size(); ++l) {
+    const size_t nfTarget = NF - std::lround(targets[l].strength * NF);
+    while (simplification.faceCount() > nfTarget) {
+      const double error = simplification.nextError();
+      if (error == Simplification::NO_COLLAPSE || error > targets[l].maxError)
+        break;
+      simplification.collapseNext();
     }
+
+    // with vertices kept, positions are written to scratch space and faces
+    // are renumbered into the input vertices
+    const MeshSize size = simplification.outputSize();
+    Mesh &lod = lods[l];
+    Positions &written = options.keepVertices ? current : lod.positions;
+    written.resize(size.vertices);
+    lod.indices.resize(size.faces);
+    origins.resize(options.keepVertices ? size.vertices : 0);
+    simplification.write(written.data(), lod.indices.data(), renumbered,
+                         options.keepVertices ? origins.data() : nullptr);
+    if (options.keepVertices)
+      for (auto &face : lod.indices)
+        for (idx &v : face) v = origins[v];
+  }
+  return lods;
+}
+
+void simplifyHeightfield(const Heightfield &field, Positions &positions,
+                         Indices &indices, const SimplifyOptions &options) {
+  const size_t width = field.width, height = field.height;
+  if (width < 2 || height < 2)
+    throw std::invalid_argument(
+        "ERROR::INPUT_MESH: heightfield has less than 2 x 2 samples");
+  if (field.heights.size() != width * height)
+    throw std::invalid_argument(
+        "ERROR::INPUT_MESH: heights are not width x height samples");
+  if (width * height > std::numeric_limits<idx>::max())
+    throw std::invalid_argument(
+        "ERROR::INPUT_MESH: heightfield has too many samples");
+
+  positions.resize(width * height);
+  for (size_t j = 0; j < height; ++j)
+    for (size_t i = 0; i < width; ++i)
+      positions[j * width + i] = {field.origin[0] + i * field.spacing[0],
+                                  field.origin[1] + j * field.spacing[1],
+                                  field.heights[j * width + i]};
+  indices = gridIndices(width, height);
+  validateOptions(options, positions.size());
+  if (options.clusterFactor > 1 || options.planarRegions)
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: clusterFactor and planarRegions cannot be "
+        "used with simplifyHeightfield()");
+
+  // lock the border
+  SimplifyOptions gridOptions = options;
+  if (gridOptions.fixedVertices.empty()) {
+    gridOptions.fixBoundary = true;
+  } else {
+    for (size_t j = 0; j < height; ++j)
+      for (size_t i = 0; i < width; ++i)
+        if (i == 0 || j == 0 || i + 1 == width || j + 1 == height)
+          gridOptions.fixedVertices[j * width + i] = true;
+  }
+
+  const size_t NF = indices.size();
+  const size_t nfTarget = NF - std::lround(options.strength * NF);
+  if (nfTarget == NF) return;
+
+  const ResourceScope scope(options.memoryResource);
+  ThreadPool pool(options.threads);
+  Simplification simplification(positions, indices, gridOptions, pool);
+  simplification.prepare(pool, [&](Vertices &vertices, Faces &faces,
+                                   Edges &edges) {
+    buildGridConnectivity(width, height, vertices, faces, edges);
+  });
+
+  simplification.collapseTo(nfTarget);
+  simplification.finish(positions, indices);
+}
+
+void simplifyScene(std::vector<Mesh> &meshes, size_t faceBudget,
+                   const SimplifyOptions &options) {
+  if (!options.fixedVertices.empty())
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: fixedVertices cannot be shared by meshes");
+  size_t nf = 0;
+  for (const auto &mesh : meshes) {
+    validateOptions(options, mesh.positions.size());
+    nf += mesh.indices.size();
   }
-  heap.prioritize();
-
-  int nf = nfToDecimate;
-  Collapser collapser(vertices, faces, heap, options);
-  while (!heap.empty() && nf > 0) {
-    // target the least-error edge, if it is what we saw last iteration,
-    // it means loop should stop because all remaining edges have been penalized
-    Edge *const edge = heap.top();
-    if (!edge->exists() || !heap.contains(edge)) {
-      heap.pop();
-      continue;
+  if (nf <= faceBudget) return;
+
+  // meshes are prepared and finished concurrently, each on one thread; the
+  // pool is only used for re-planning during the collapses
+  ThreadPool pool(options.threads);
+  std::vector<std::unique_ptr<Simplification>> simplifications(meshes.size());
+  pool.parallelFor(meshes.size(), 1, [&](size_t b, size_t e) {
+    const ResourceScope scope(options.memoryResource);
+    ThreadPool serial(1);
+    for (size_t m = b; m < e; ++m) {
+      simplifications[m].reset(new Simplification(
+          meshes[m].positions, meshes[m].indices, options, pool));
+      simplifications[m]->prepare(serial);
     }
-    if (edge->error() >= std::numeric_limits<double>::max()) break;
+  });
+
+  // a single queue of meshes ordered by the error of their next collapse:
+  // collapses are interleaved across meshes in order of error, as if all
+  // meshes were one. ties go to the mesh listed first
+  typedef std::pair<double, size_t> Next;
+  std::priority_queue<Next, std::vector<Next>, std::greater<Next>> queue;
+  for (size_t m = 0; m < meshes.size(); ++m) {
+    const double error = simplifications[m]->nextError();
+    if (error < Simplification::NO_COLLAPSE) queue.emplace(error, m);
+  }
+
+  while (nf > faceBudget && !queue.empty()) {
+    const size_t m = queue.top().second;
+    queue.pop();
+    nf -= simplifications[m]->collapseNext();
+
+    const double error = simplifications[m]->nextError();
+    if (error < Simplification::NO_COLLAPSE) queue.emplace(error, m);
+  }
+
+  pool.parallelFor(meshes.size(), 1, [&](size_t b, size_t e) {
+    for (size_t m = b; m < e; ++m)
+      simplifications[m]->finish(meshes[m].positions, meshes[m].indices);
+  });
+}
+
+void simplifyComponents(Positions &positions, Indices &indices,
+                        const SimplifyOptions &options, bool shareBudget) {
+  validateOptions(options, positions.size());
+  if (shareBudget && !options.fixedVertices.empty())
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: fixedVertices cannot be used with a shared "
+        "budget");
+
+  std::vector<Component> components = splitComponents(positions, indices);
+
+  if (shareBudget) {
+    std::vector<Mesh> meshes;
+    meshes.reserve(components.size());
+    for (auto &component : components)
+      meshes.push_back(std::move(component.mesh));
+
+    const size_t NF = indices.size();
+    simplifyScene(meshes, NF - std::lround(options.strength * NF), options);
 
-    // collapse the least-error edge until mesh is simplified enough
-    int removed = collapser.collapse(edge);
-    nf -= removed;
+    for (size_t c = 0; c < components.size(); ++c)
+      components[c].mesh = std::move(meshes[c]);
+  } else {
+    // no collapse spans two components, so they are simplified concurrently
+    // with one thread each
+    ThreadPool pool(options.threads);
+    pool.parallelFor(components.size(), 1, [&](size_t b, size_t e) {
+      SimplifyOptions componentOptions = options;
+      componentOptions.threads = 1;
+      componentOptions.collapseLog = nullptr;
+      for (size_t c = b; c < e; ++c) {
+        Component &component = components[c];
+        if (!options.fixedVertices.empty()) {
+          componentOptions.fixedVertices.resize(component.vertices.size());
+          for (idx v = 0; v < component.vertices.size(); ++v)
+            componentOptions.fixedVertices[v] =
+                options.fixedVertices[component.vertices[v]];
+        }
+        simplify(component.mesh.positions, component.mesh.indices,
+                 componentOptions);
+      }
+    });
   }
 
-  vertices.eraseUnref(faces);
+  joinComponents(components, positions, indices);
+}
+
+void simplifyOutOfCore(TriangleSource &source, Positions &positions,
+                       Indices &indices, const OutOfCoreOptions &options) {
+  // leave room for refining the clustered mesh in the budget
+  const size_t faceBytes = options.faces > 0 ? COLLAPSE_FACE_BYTES : 0;
+  std::vector<Quadric> quadrics;
+  clusterOutOfCore(source, options, faceBytes, positions, indices, quadrics);
+  if (options.faces == 0 || indices.size() <= options.faces) return;
+
+  makeManifold(positions, indices, quadrics);
+  SimplifyOptions refineOptions;
+  refineOptions.weightByArea = options.weightByArea;
+  refineOptions.threads = options.threads;
+  ThreadPool pool(options.threads);
+  Simplification simplification(positions, indices, refineOptions, pool,
+                                &quadrics);
+  simplification.prepare(pool);
 
-  // edges are useless
-  // faces and vertices will be used to generate indices and positions
-  // then they are useless as well
-  faces.compactIndicesAndDie(indices);
-  vertices.compactPositionsAndDie(positions, indices);
+  simplification.collapseTo(options.faces);
+  simplification.finish(positions, indices);
 }
 
 }  // namespace MeshSimpl
@@ -5,13 +5,16 @@
 #ifndef MESH_SIMPL_SIMPLIFY_HPP
 #define MESH_SIMPL_SIMPLIFY_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include "types.hpp"
 
 namespace MeshSimpl {
 
 namespace Internal {
-void validateOptions(const SimplifyOptions& options,
-                     const Positions& positions);
+void validateOptions(const SimplifyOptions& options, size_t vertexCount);
 }  // namespace Internal
 
 // Simplify the mesh defined by vertex positions and face indices with an
@@ -19,6 +22,104 @@ void validateOptions(const SimplifyOptions& options,
 void simplify(Positions& positions, Indices& indices,
               const SimplifyOptions& options = {});
 
+// Simplify a mesh of single precision positions, e.g., from a renderer.
+// Positions and quadrics are stored in float as well, halving the memory of
+// vertices, while errors and positions of collapses are computed in double.
+// clusterFactor and planarRegions are not supported
+void simplify(PositionsF& positions, Indices& indices,
+              const SimplifyOptions& options = {});
+
+// Simplify a mesh in caller-owned buffers without converting it first:
+// positions are read and moved in place in `vertices`, and `faceCount` faces
+// are read from `indices`, three per face, and written back. Each output
+// vertex takes the whole record of the input vertex it stands for, so other
+// interleaved attributes follow their position. Float positions are stored
+// as by the single precision simplify(); clusterFactor and planarRegions are
+// not supported. Returns the size of the result, a prefix of the buffers;
+// if this throws after reading the mesh, positions may have moved. Indices
+// may be of type uint16_t, uint32_t or uint64_t whatever idx is
+template <typename I>
+MeshSize simplify(const VertexBuffer& vertices, I* indices, size_t faceCount,
+                  const SimplifyOptions& options = {});
+
+// Simplify as simplify() with keepVertices set, leaving the positions as they
+// are, and return the faces of the result indexing them; vertices the result
+// does not use are not removed. Levels of detail can thus share one vertex
+// buffer and differ only in their indices. A vertex split to fix the topology
+// indexes the vertex it was split from. clusterFactor and planarRegions are
+// not supported
+Indices simplifyIndices(const Positions& positions, const Indices& indices,
+                        const SimplifyOptions& options = {});
+Indices simplifyIndices(const PositionsF& positions, const Indices& indices,
+                        const SimplifyOptions& options = {});
+
+// Simplify a mesh into levels of detail in a single run: the collapses are
+// done once, as by simplify(), and the mesh is copied out each time one of
+// `targets`, ordered from fine to coarse, is reached. A level of strength s
+// is the result of simplify() at strength s. If options.keepVertices, levels
+// have no positions and their indices refer to `positions`, see
+// simplifyIndices(). options.strength is ignored; clusterFactor and
+// planarRegions are not supported
+std::vector<Mesh> simplifyLods(const Positions& positions,
+                               const Indices& indices,
+                               const std::vector<LodTarget>& targets,
+                               const SimplifyOptions& options = {});
+
+// Simplify a heightfield triangulated as two faces per grid cell, split along
+// the diagonal from sample (i, j) to (i + 1, j + 1), and write the result.
+// Connectivity follows from the grid instead of being searched for, and the
+// border is locked, so adjacent tiles sharing border samples can be simplified
+// independently, e.g., concurrently, and still fit without cracks.
+// clusterFactor and planarRegions are not supported
+void simplifyHeightfield(const Heightfield& field, Positions& positions,
+                         Indices& indices, const SimplifyOptions& options = {});
+
+// Simplify the meshes of a scene together until their total face count is
+// at most `faceBudget`. Edges are collapsed in order of error across all
+// meshes, so the budget goes where it keeps the error of the scene lowest
+// instead of being split evenly. `strength` is ignored and `fixedVertices`
+// must be empty; `threads` also prepare meshes concurrently
+void simplifyScene(std::vector<Mesh>& meshes, size_t faceBudget,
+                   const SimplifyOptions& options = {});
+
+// Simplify every connected component of the mesh on its own and concatenate
+// the results; no collapse can span two components, so they are simplified
+// concurrently on `threads`. Each component keeps 1-strength of its faces,
+// or, if shareBudget, components compete for the total budget as in
+// simplifyScene()
+void simplifyComponents(Positions& positions, Indices& indices,
+                        const SimplifyOptions& options = {},
+                        bool shareBudget = false);
+
+// Simplify by vertex clustering: vertices are merged per cell of a uniform
+// grid and moved to the point of least quadric error in the cell, and faces
+// left with less than three vertices are dropped. Much faster than simplify()
+// and uses memory in proportion to the output, at the cost of quality; the
+// topology is not preserved. Change is written in-place.
+void cluster(Positions& positions, Indices& indices,
+             const ClusterOptions& options = {});
+
+// Simplify a mesh too large for memory, read three times from `source` as
+// triangle soup, and write the result. Vertices are clustered as by cluster()
+// on a grid that is coarsened, cells merging in twos along each axis, as long
+// as the cells and faces would exceed options.memoryBudget; the result is
+// then refined by edge collapse if options.faces asks for fewer faces. Memory
+// does not grow with the input, and reading the input takes most of the time
+void simplifyOutOfCore(TriangleSource& source, Positions& positions,
+                       Indices& indices, const OutOfCoreOptions& options = {});
+
+// Best ISA level of vectorized kernels supported by this CPU
+IsaLevel supportedIsaLevel();
+
+// ISA level of vectorized kernels in use. It is the supported level unless
+// the environment variable MESH_SIMPL_ISA names a lower one (generic, sse4.2,
+// avx2 or avx512) or it was forced by setIsaLevel()
+IsaLevel isaLevel();
+
+// Force an ISA level, e.g., to benchmark or test one; throws if this CPU does
+// not support it. Output does not depend on the level
+void setIsaLevel(IsaLevel level);
+
 }  // namespace MeshSimpl
 
 #endif  // MESH_SIMPL_SIMPLIFY_HPP
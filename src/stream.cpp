@@ -0,0 +1,190 @@
+#include "stream.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "parallel.hpp"
+#include "simplification.hpp"
+#include "simplify.hpp"
+
+namespace MeshSimpl {
+
+using namespace Internal;
+
+static const idx NONE = std::numeric_limits<idx>::max();
+
+StreamSimplifier::StreamSimplifier(MeshSink& sink,
+                                   const SimplifyOptions& options,
+                                   size_t window)
+    : sink(sink), options(options), window(window), nfNext(window) {
+  validateOptions(options, 0);
+  if (!options.fixedVertices.empty() || options.clusterFactor > 1 ||
+      options.planarRegions)
+    throw std::invalid_argument(
+        "ERROR::INVALID_OPTION: fixedVertices, clusterFactor and "
+        "planarRegions cannot be used with a stream");
+}
+
+void StreamSimplifier::addVertex(const vec3d& position) {
+  slots[nvAdded] = positions.size();
+  positions.push_back(position);
+  inputIds.push_back(nvAdded++);
+  outputIds.push_back(NONE);
+  finalized.push_back(false);
+}
+
+void StreamSimplifier::addFace(const vec3i& face) {
+  vec3i slotFace;
+  for (order k = 0; k < 3; ++k) {
+    const auto it = slots.find(face[k]);
+    if (it == slots.end())
+      throw std::invalid_argument(
+          "ERROR::INPUT_MESH: face refers to a vertex not added or finalized");
+    slotFace[k] = it->second;
+  }
+  indices.push_back(slotFace);
+  ++nfAdded;
+
+  if (indices.size() >= nfNext) {
+    simplifyWindow();
+    writeSettled();
+    nfNext = std::max(window, 2 * indices.size());
+  }
+}
+
+void StreamSimplifier::finalize(idx v) {
+  const auto it = slots.find(v);
+  if (it == slots.end())
+    throw std::invalid_argument(
+        "ERROR::INPUT_MESH: finalized vertex not added or finalized before");
+  finalized[it->second] = true;
+  slots.erase(it);
+}
+
+void StreamSimplifier::finish() {
+  for (const auto& slot : slots) finalized[slot.second] = true;
+  slots.clear();
+  simplifyWindow();
+  writeSettled();
+}
+
+void StreamSimplifier::simplifyWindow() {
+  // faces written and in the window should be 1-strength of those added
+  const size_t nfKept = nfAdded - std::lround(options.strength * nfAdded);
+  if (indices.empty() || nfWritten + indices.size() <= nfKept) return;
+  const size_t nfTarget = nfKept > nfWritten ? nfKept - nfWritten : 0;
+
+  // the mesh of the faces in the window; vertices not finalized, or written
+  // and thus used by faces outside, are fixed
+  const idx NV = positions.size();
+  std::vector<idx> local(NV, NONE), slotOf;
+  Positions localPositions;
+  Indices localIndices(indices);
+  SimplifyOptions localOptions = options;
+  for (auto& face : localIndices) {
+    for (idx& v : face) {
+      if (local[v] == NONE) {
+        local[v] = slotOf.size();
+        slotOf.push_back(v);
+        localPositions.push_back(positions[v]);
+        localOptions.fixedVertices.push_back(!finalized[v] ||
+                                             outputIds[v] != NONE);
+      }
+      v = local[v];
+    }
+  }
+
+  ThreadPool pool(options.threads);
+  Simplification simplification(localPositions, localIndices, localOptions,
+                                pool);
+  simplification.trackOrigins();
+  simplification.prepare(pool);
+  simplification.collapseTo(nfTarget);
+  std::vector<idx> origins;
+  simplification.finish(localPositions, localIndices, &origins);
+
+  // vertices not used by faces stay as they are; every other one is replaced
+  // by what stands for it. a vertex split off is a new one, and finalized as
+  // faces added later use the vertex it was split from
+  Positions newPositions;
+  std::vector<idx> newInputIds, newOutputIds;
+  std::vector<bool> newFinalized;
+  const auto keep = [&](idx v, const vec3d& position, bool split) {
+    if (!finalized[v] && !split) slots[inputIds[v]] = newPositions.size();
+    newPositions.push_back(position);
+    newInputIds.push_back(inputIds[v]);
+    newOutputIds.push_back(split ? NONE : outputIds[v]);
+    newFinalized.push_back(finalized[v] || split);
+  };
+  for (idx v = 0; v < NV; ++v)
+    if (local[v] == NONE) keep(v, positions[v], false);
+  std::vector<char> taken(slotOf.size(), 0);
+  for (idx u = 0; u < localPositions.size(); ++u) {
+    keep(slotOf[origins[u]], localPositions[u], taken[origins[u]]);
+    taken[origins[u]] = 1;
+    origins[u] = newPositions.size() - 1;
+  }
+  for (auto& face : localIndices)
+    for (idx& u : face) u = origins[u];
+
+  positions.swap(newPositions);
+  inputIds.swap(newInputIds);
+  outputIds.swap(newOutputIds);
+  finalized.swap(newFinalized);
+  indices.swap(localIndices);
+}
+
+void StreamSimplifier::writeSettled() {
+  // a face is settled if its vertices and their neighbors are finalized, so
+  // no collapse can change it any more but those into its vertices
+  std::vector<char> settled(finalized.begin(), finalized.end());
+  for (const auto& face : indices)
+    if (!finalized[face[0]] || !finalized[face[1]] || !finalized[face[2]])
+      for (idx v : face) settled[v] = 0;
+
+  size_t nf = 0;
+  for (const auto& face : indices) {
+    if (!settled[face[0]] || !settled[face[1]] || !settled[face[2]]) {
+      indices[nf++] = face;
+      continue;
+    }
+    vec3i written;
+    for (order k = 0; k < 3; ++k) {
+      idx& id = outputIds[face[k]];
+      if (id == NONE) {
+        id = nvWritten++;
+        sink.vertex(positions[face[k]]);
+      }
+      written[k] = id;
+    }
+    sink.face(written);
+    ++nfWritten;
+  }
+  indices.resize(nf);
+
+  // forget finalized vertices no longer used
+  std::vector<idx> remap(positions.size(), NONE);
+  for (const auto& face : indices)
+    for (idx v : face) remap[v] = 0;
+  idx nv = 0;
+  for (idx v = 0; v < positions.size(); ++v) {
+    if (finalized[v] && remap[v] == NONE) continue;
+    remap[v] = nv;
+    if (!finalized[v]) slots[inputIds[v]] = nv;
+    positions[nv] = positions[v];
+    inputIds[nv] = inputIds[v];
+    outputIds[nv] = outputIds[v];
+    finalized[nv] = finalized[v];
+    ++nv;
+  }
+  positions.resize(nv);
+  inputIds.resize(nv);
+  outputIds.resize(nv);
+  finalized.resize(nv);
+  for (auto& face : indices)
+    for (idx& v : face) v = remap[v];
+}
+
+}  // namespace MeshSimpl
@@ -0,0 +1,78 @@
+#ifndef MESH_SIMPL_STREAM_HPP
+#define MESH_SIMPL_STREAM_HPP
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "types.hpp"
+
+namespace MeshSimpl {
+
+// Receives a mesh in streaming order: every vertex before the first face
+// using it. Vertices are numbered from 0 in the order they are received
+class MeshSink {
+ public:
+  virtual ~MeshSink() = default;
+
+  virtual void vertex(const vec3d& position) = 0;
+
+  virtual void face(const vec3i& face) = 0;
+};
+
+// Simplify a streaming mesh (Isenburg and Lindstrom), whose vertices and faces
+// come interleaved, every vertex being finalized once the last face using it
+// has come. Faces are kept in an in-core window, simplified from time to time
+// by collapsing edges between finalized vertices, to about 1-strength of the
+// faces added so far; faces whose vertices and their neighbors are finalized
+// are then written to the sink and forgotten. Memory grows with the front of
+// vertices not finalized rather than with the mesh. Quadrics are recomputed
+// from the faces in the window every time it is simplified
+class StreamSimplifier {
+ public:
+  // The window is simplified each time it holds `window` faces or twice as
+  // many as were left in it the last time. fixedVertices, clusterFactor and
+  // planarRegions are not supported
+  StreamSimplifier(MeshSink& sink, const SimplifyOptions& options = {},
+                   size_t window = 1 << 16);
+
+  // Add the next vertex; vertices are numbered from 0 in order
+  void addVertex(const vec3d& position);
+
+  // Add a face on vertices added and not finalized
+  void addFace(const vec3i& face);
+
+  // Declare that no face added from now on uses vertex v
+  void finalize(idx v);
+
+  // End the stream: finalize all vertices and write all faces left
+  void finish();
+
+ private:
+  void simplifyWindow();
+  void writeSettled();
+
+  MeshSink& sink;
+  const SimplifyOptions options;
+  const size_t window;
+  size_t nfNext;         // face count of the window to simplify it at
+  size_t nfAdded = 0;    // faces added
+  size_t nfWritten = 0;  // faces written
+  idx nvAdded = 0;       // vertices added
+  idx nvWritten = 0;     // vertices written
+
+  // the window: vertices not finalized or used by faces in it, and faces
+  // not written
+  Positions positions;
+  std::vector<idx> inputIds;   // number of a vertex in the input
+  std::vector<idx> outputIds;  // number in the output if written
+  std::vector<bool> finalized;
+  Indices indices;
+
+  // vertices not finalized: position in the window by number in the input
+  std::unordered_map<idx, idx> slots;
+};
+
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_STREAM_HPP
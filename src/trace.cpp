@@ -0,0 +1,128 @@
+#include "trace.hpp"
+
+#include <cassert>
+#include <limits>
+#include <vector>
+
+#include "faces.hpp"
+#include "vertices.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+void CollapseTrace::clear() {
+  collapses.clear();
+  erasedFaces.clear();
+  erasedCorners.clear();
+  corners.clear();
+  forks.clear();
+}
+
+void CollapseTrace::begin(idx vKept, idx vDel, const vec3d& keptPosition) {
+  Collapse collapse;
+  collapse.kept = vKept;
+  collapse.deleted = vDel;
+  collapse.keptPosition = keptPosition;
+  collapse.center = keptPosition;
+  collapse.facesBegin = erasedFaces.size();
+  collapse.cornersBegin = corners.size();
+  collapse.forksBegin = forks.size();
+  collapses.push_back(collapse);
+}
+
+void CollapseTrace::eraseFace(idx f, const vec3i& corners) {
+  erasedFaces.push_back(f);
+  erasedCorners.push_back(corners);
+}
+
+void CollapseTrace::setV(idx f, order k, idx before, idx after) {
+  Corner corner;
+  corner.f = f;
+  corner.k = k;
+  corner.before = before;
+  corner.after = after;
+  corners.push_back(corner);
+}
+
+void CollapseTrace::fork(idx v, idx source) { forks.push_back({{v, source}}); }
+
+void CollapseTrace::write(const Vertices& vertices, const Faces& faces,
+                          CollapseLog& log) const {
+  static const idx NONE = std::numeric_limits<idx>::max();
+
+  // vertices and faces of the base mesh are numbered as in the output
+  std::vector<idx> vNumber;
+  log.baseVertices = vertices.renumber(vNumber);
+  for (idx v = 0; v < vertices.size(); ++v)
+    if (!vertices.exists(v)) vNumber[v] = NONE;
+  std::vector<idx> fNumber(faces.size());
+  for (idx f = 0; f < faces.size(); ++f)
+    fNumber[f] = faces.exists(f) ? f : NONE;
+  log.baseFaces =
+      faces.compactOrder([&](idx from, idx to) { fNumber[from] = to; });
+
+  log.splits.clear();
+  log.positions.clear();
+  log.faces.clear();
+  log.corners.clear();
+  log.forks.clear();
+
+  // undo the collapses last to first, numbering vertices and faces as they
+  // come back; `positions` follows the mesh, so a vertex is numbered with
+  // its position at the level it comes back
+  Positions positions(vertices.size());
+  for (idx v = 0; v < vertices.size(); ++v)
+    positions[v] = vertices.position(v);
+  idx nextFace = log.baseFaces;
+  const auto number = [&](idx v) {
+    if (vNumber[v] == NONE) {
+      vNumber[v] = log.baseVertices + log.positions.size();
+      log.positions.push_back(positions[v]);
+    }
+    return vNumber[v];
+  };
+
+  for (size_t c = collapses.size(); c-- > 0;) {
+    const Collapse& collapse = collapses[c];
+    const bool last = c + 1 == collapses.size();
+    const size_t facesEnd =
+        last ? erasedFaces.size() : collapses[c + 1].facesBegin;
+    const size_t cornersEnd =
+        last ? corners.size() : collapses[c + 1].cornersBegin;
+    const size_t forksEnd = last ? forks.size() : collapses[c + 1].forksBegin;
+    positions[collapse.kept] = collapse.keptPosition;
+
+    CollapseLog::Split split;
+    split.deleted = number(collapse.deleted);
+    split.kept = number(collapse.kept);
+    split.keptPosition = collapse.keptPosition;
+    split.center = collapse.center;
+
+    for (size_t i = collapse.facesBegin; i < facesEnd; ++i) {
+      fNumber[erasedFaces[i]] = nextFace++;
+      vec3i face;
+      for (order k = 0; k < 3; ++k) face[k] = number(erasedCorners[i][k]);
+      log.faces.push_back(face);
+    }
+    for (size_t i = collapse.cornersBegin; i < cornersEnd; ++i) {
+      assert(fNumber[corners[i].f] != NONE);
+      CollapseLog::Corner corner;
+      corner.face = fNumber[corners[i].f];
+      corner.coarse = number(corners[i].after);
+      corner.fine = number(corners[i].before);
+      corner.k = corners[i].k;
+      log.corners.push_back(corner);
+    }
+    for (size_t i = collapse.forksBegin; i < forksEnd; ++i)
+      log.forks.push_back({{number(forks[i][0]), number(forks[i][1])}});
+
+    split.vertexEnd = log.positions.size();
+    split.faceEnd = log.faces.size();
+    split.cornerEnd = log.corners.size();
+    split.forkEnd = log.forks.size();
+    log.splits.push_back(split);
+  }
+}
+
+}  // namespace Internal
+}  // namespace MeshSimpl
@@ -0,0 +1,64 @@
+#ifndef MESH_SIMPL_TRACE_HPP
+#define MESH_SIMPL_TRACE_HPP
+
+#include <array>
+#include <cstddef>
+
+#include "memory.hpp"
+#include "progressive.hpp"
+#include "types.hpp"
+
+namespace MeshSimpl {
+namespace Internal {
+
+class Faces;
+class Vertices;
+
+// Collapses accepted by Collapser, in the order they were done and in the
+// numbers of vertices and faces during the simplification
+class CollapseTrace {
+ public:
+  void clear();
+
+  // Start the record of collapsing vDel into vKept, before anything changes
+  void begin(idx vKept, idx vDel, const vec3d& keptPosition);
+
+  // Record where vKept moved to
+  void setCenter(const vec3d& center) { collapses.back().center = center; }
+
+  // Record changes as they are made
+  void eraseFace(idx f, const vec3i& corners);
+  void setV(idx f, order k, idx before, idx after);
+  void fork(idx v, idx source);
+
+  // Write the splits undoing the collapses, with vertices and faces numbered
+  // as finish() outputs them. Unreferenced vertices must be erased, see
+  // Vertices::eraseUnref(), and vertices and faces must not change until
+  // then
+  void write(const Vertices& vertices, const Faces& faces,
+             CollapseLog& log) const;
+
+ private:
+  struct Collapse {
+    idx kept, deleted;
+    vec3d keptPosition, center;
+    size_t facesBegin, cornersBegin, forksBegin;
+  };
+
+  struct Corner {
+    idx f;
+    order k;
+    idx before, after;
+  };
+
+  Array<Collapse> collapses;
+  Array<idx> erasedFaces;
+  Array<vec3i> erasedCorners;
+  Array<Corner> corners;
+  Array<std::array<idx, 2>> forks;
+};
+
+}  // namespace Internal
+}  // namespace MeshSimpl
+
+#endif  // MESH_SIMPL_TRACE_HPP
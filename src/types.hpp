@@ -7,21 +7,95 @@
 
 #include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <vector>
 
+#include "memory.hpp"
+
 namespace MeshSimpl {
 
-typedef unsigned int idx;             // edge, vertex, face index
+struct CollapseLog;
+
+// edge, vertex, face index; 64 bits if built with MESH_SIMPL_64BIT_INDEX for
+// meshes of more than 2^32 elements, at the cost of memory and bandwidth
+#ifdef MESH_SIMPL_64BIT_INDEX
+typedef uint64_t idx;
+#else
+typedef uint32_t idx;
+#endif
 typedef char order;                   // edge/vertex local order to face; [0, 3)
 typedef std::array<double, 3> vec3d;  // double
+typedef std::array<float, 3> vec3f;   // float
 typedef std::array<idx, 3> vec3i;     // idx
 typedef std::array<idx, 2> vec2i;     // idx
 
 typedef std::vector<vec3i> Indices;
 typedef std::vector<vec3d> Positions;
+typedef std::vector<vec3f> PositionsF;
 
 static const order INVALID = -1;
 
+// One of the meshes simplified together by simplifyScene()
+struct Mesh {
+  Positions positions;
+  Indices indices;
+};
+
+// A level of detail of simplifyLods(): the mesh once at most 1-strength of
+// the input faces are left, or before the first collapse of error above
+// maxError, whichever comes first
+struct LodTarget {
+  LodTarget(float strength = 0.0f,
+            double maxError = std::numeric_limits<double>::infinity())
+      : strength(strength), maxError(maxError) {}
+
+  float strength;
+  double maxError;
+};
+
+// A vertex buffer owned by the caller, e.g., mapped from the GPU: `count`
+// vertices of `stride` bytes each, starting at `data`, whose first bytes are
+// the position as three floats, or doubles if `doublePrecision`. Other
+// attributes may be interleaved after the position. A stride of 0 means
+// positions are tightly packed
+struct VertexBuffer {
+  void* data = nullptr;
+  size_t count = 0;
+  size_t stride = 0;
+  bool doublePrecision = false;
+};
+
+// Number of vertices and faces of a simplified mesh
+struct MeshSize {
+  size_t vertices = 0;
+  size_t faces = 0;
+};
+
+// A regular grid of heights, e.g., a terrain tile. Sample (i, j) is at
+// (origin[0] + i * spacing[0], origin[1] + j * spacing[1], heights[j * width
+// + i])
+struct Heightfield {
+  size_t width = 0;   // samples along x
+  size_t height = 0;  // samples along y
+  std::vector<double> heights;
+  std::array<double, 2> origin = {{0, 0}};
+  std::array<double, 2> spacing = {{1, 1}};
+};
+
+// Instruction set levels the vectorized kernels are compiled for; ordered
+// from the most to the least widely supported
+enum class IsaLevel { GENERIC, SSE42, AVX2, AVX512 };
+
+// Placement of internal arrays on the memory nodes of NUMA machines
+enum class MemoryPlacement {
+  FIRST_TOUCH,  // left to the OS: pages stay on the node of the calling thread
+  INTERLEAVED,  // pages are spread round-robin over all nodes
+  PARTITIONED   // arrays are split into one block per thread, each block on
+                // the node of the thread that processes it
+};
+
 struct SimplifyOptions {
   // simplifies until face count is 1-strength of the original,
   // only accept value in range [0, 1)
@@ -40,6 +114,64 @@ struct SimplifyOptions {
 
   bool topologyModifiable = false;
 
+  // collapse edges only into the endpoint of lower error instead of the point
+  // of least error, so every vertex of the result is at an input vertex, at
+  // the cost of a larger error; see simplifyIndices()
+  bool keepVertices = false;
+
+  // memoryless simplification (Lindstrom and Turk): no quadrics are stored and
+  // the error of a collapse is measured against the planes of the faces
+  // around the edge as they are now, not as they were in the input. Uses less
+  // memory at the cost of a slightly larger error
+  bool memoryless = false;
+
+  // if nonzero, collapse the best of this many edges drawn at random instead
+  // of the best of all edges (multiple-choice, Wu and Kobbelt). No heap is
+  // kept, which is faster, at the cost of a slightly larger error; draws are
+  // reproducible
+  unsigned candidates = 0;
+
+  // if positive, edges whose errors are within this relative width of each
+  // other, rounded down to a power of 2 and at least 2^-10, share a bucket
+  // and are collapsed in any order instead of in order of error. Updating
+  // the order of edges takes constant time instead of logarithmic; ignored if
+  // candidates is set
+  float bucketWidth = 0.0f;
+
+  // number of threads used to plan edge collapses; the collapse order and the
+  // output do not depend on it. 0 uses one thread per hardware thread
+  unsigned threads = 1;
+
+  // where internal arrays live on NUMA machines; threads are pinned to nodes
+  // unless it is FIRST_TOUCH
+  MemoryPlacement placement = MemoryPlacement::FIRST_TOUCH;
+
+  // resource the internal arrays of vertices, faces, edges and the queue are
+  // allocated from, e.g., a MonotonicArena released after each job; it must
+  // outlive the simplification, or the Simplifier, and be thread-safe if
+  // simplifyScene() or simplifyComponents() run on several threads. Null uses
+  // the global heap. Positions and indices keep their allocator
+  MemoryResource* memoryResource = nullptr;
+
+  // if not null, simplify() writes its collapses to it, so that its result
+  // can be refined back into its input one vertex split at a time, see
+  // ProgressiveMesh; with clusterFactor or planarRegions, back into the mesh
+  // they leave. Ignored by other functions
+  CollapseLog* collapseLog = nullptr;
+
+  // if greater than 1 and the mesh is to lose more than that many times its
+  // target face count, it is first brought to about clusterFactor times the
+  // target by vertex clustering, which is fast and needs little memory, and
+  // then refined by edge collapse seeded with the quadrics of the clusters.
+  // Topology is not preserved; fixedVertices must be empty
+  float clusterFactor = 0.0f;
+
+  // first replace every connected region of coplanar faces that is a disk by
+  // a triangulation of its boundary, removing its interior vertices at no
+  // error, e.g., the finely tessellated flat parts of CAD meshes. Counts
+  // towards strength
+  bool planarRegions = false;
+
   // the following are very fine grained configuration options
 
   // the constant that decides the weight of constraint planes (if fixBoundary
@@ -63,12 +195,58 @@ struct SimplifyOptions {
   std::vector<bool> fixedVertices = {};
 };
 
+struct ClusterOptions {
+  // number of grid cells along the longest side of the bounding box; the
+  // output has at most one vertex per cell
+  unsigned resolution = 64;
+
+  // weight the quadrics by triangle area
+  bool weightByArea = true;
+
+  // number of threads; the output does not depend on it. 0 uses one thread
+  // per hardware thread
+  unsigned threads = 1;
+};
+
+// Triangle soup read by simplifyOutOfCore(), e.g., from a file; it must give
+// the same triangles in the same order every time it is read
+class TriangleSource {
+ public:
+  virtual ~TriangleSource() = default;
+
+  // Go back to the first triangle
+  virtual void rewind() = 0;
+
+  // Read the next triangle; false if none is left
+  virtual bool next(std::array<vec3d, 3>& corners) = 0;
+};
+
+struct OutOfCoreOptions {
+  // bytes of memory that cells, output faces and the refinement may take;
+  // the grid is coarsened whenever they would take more
+  size_t memoryBudget = size_t(256) << 20;
+
+  // number of grid cells along the longest side of the bounding box before
+  // any coarsening
+  unsigned resolution = 1024;
+
+  // if nonzero, the clustered mesh is refined by edge collapse to this many
+  // faces, seeded with the quadrics of the clusters
+  size_t faces = 0;
+
+  // weight the quadrics by triangle area
+  bool weightByArea = true;
+
+  // number of threads planning edge collapses of the refinement
+  unsigned threads = 1;
+};
+
 namespace Internal {
 
 // Defined in edge.hpp
 class Edge;
 
-typedef std::vector<Edge> Edges;
+typedef Array<Edge> Edges;
 
 }  // namespace Internal
 
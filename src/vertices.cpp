@@ -2,43 +2,166 @@
 // Created by nickl on 6/9/19.
 //
 
-#include <array>
-#include <initializer_list>
+#include <algorithm>
+#include <utility>
 
 #include "vertices.hpp"
 
 namespace MeshSimpl {
 namespace Internal {
 
-void Vertices::compactPositionsAndDie(Positions& positions, Indices& indices) {
-  std::vector<std::array<std::vector<idx>, 3>> vertex2face(size());
+Vertices::Vertices(PositionsF& positions, bool withQuadrics)
+    : Erasables(positions.size()),
+      _positionsF(std::move(positions)),
+      _quadricsF(withQuadrics ? size() : 0),
+      _boundary(size(), false),
+      _fixed(size(), false),
+      _withQuadrics(withQuadrics) {
+  centerQuadrics();
+}
 
-  // create mapping from v to f
-  for (idx f = 0; f < indices.size(); ++f) {
-    for (idx i = 0; i < 3; ++i) vertex2face[indices[f][i]][i].push_back(f);
-  }
+Vertices::Vertices(const VertexBuffer& buffer, size_t stride,
+                   bool withQuadrics)
+    : Erasables(buffer.count),
+      _quadrics(withQuadrics && buffer.doublePrecision ? size() : 0),
+      _quadricsF(withQuadrics && !buffer.doublePrecision ? size() : 0),
+      _boundary(size(), false),
+      _fixed(size(), false),
+      _withQuadrics(withQuadrics),
+      _records(static_cast<char*>(buffer.data)),
+      _stride(stride),
+      _recordsSingle(!buffer.doublePrecision),
+      _inRecords(true) {
+  centerQuadrics();
+}
 
-  // get rid of deleted vertices and keep the mapping valid
-  for (int lo = 0, hi = size() - 1; true; ++lo, --hi) {
-    while (lo <= hi && exists(lo)) ++lo;
-    while (lo < hi && !exists(hi)) --hi;
-    if (lo >= hi) {
-      _positions.resize(lo);
-      vertex2face.resize(lo);
-      break;
+void Vertices::centerQuadrics() {
+  if (_quadricsF.empty() || size() == 0) return;
+  vec3d lo = position(0), hi = lo;
+  for (idx v = 1; v < size(); ++v) {
+    const vec3d pos = position(v);
+    for (int i = 0; i < 3; ++i) {
+      lo[i] = std::min(lo[i], pos[i]);
+      hi[i] = std::max(hi[i], pos[i]);
     }
-    std::swap(vertex2face[lo], vertex2face[hi]);
-    std::swap(_positions[lo], _positions[hi]);
   }
+  for (int i = 0; i < 3; ++i) _center[i] = (lo[i] + hi[i]) / 2;
+}
+
+void Vertices::leaveRecords() {
+  if (_recordsSingle) {
+    _positionsF.resize(size());
+    for (idx v = 0; v < size(); ++v)
+      std::memcpy(_positionsF[v].data(), _records + v * _stride,
+                  sizeof(vec3f));
+  } else {
+    _positions.resize(size());
+    for (idx v = 0; v < size(); ++v)
+      std::memcpy(_positions[v].data(), _records + v * _stride,
+                  sizeof(vec3d));
+  }
+  _inRecords = false;
+}
 
-  // move to output
-  positions = std::move(_positions);
+void Vertices::compact(Indices& indices) {
+  std::vector<idx> renumbered;
+  renumber(renumbered);
+
+  // get rid of deleted vertices
+  const size_t nv = compactOrder([&](idx from, idx to) {
+    if (_positionsF.empty())
+      std::swap(_positions[from], _positions[to]);
+    else
+      std::swap(_positionsF[from], _positionsF[to]);
+    if (!_origins.empty()) std::swap(_origins[from], _origins[to]);
+  });
+  if (_positionsF.empty())
+    _positions.resize(nv);
+  else
+    _positionsF.resize(nv);
+  if (!_origins.empty()) _origins.resize(nv);
 
   // update indices
-  for (idx v = 0; v < vertex2face.size(); ++v) {
-    for (order i : {0, 1, 2})
-      for (idx f : vertex2face[v][i]) indices[f][i] = v;
+  for (auto& face : indices)
+    for (idx& v : face) v = renumbered[v];
+}
+
+size_t Vertices::renumber(std::vector<idx>& renumbered) const {
+  renumbered.resize(size());
+  for (idx v = 0; v < size(); ++v) renumbered[v] = v;
+  return compactOrder([&](idx from, idx to) { renumbered[from] = to; });
+}
+
+void Vertices::writeCompacted(std::vector<idx>& renumbered, vec3d* positions,
+                              idx* origins) const {
+  renumber(renumbered);
+  for (idx v = 0; v < size(); ++v) {
+    if (!exists(v)) continue;
+    positions[renumbered[v]] = position(v);
+    if (origins) origins[renumbered[v]] = origin(v);
+  }
+}
+
+size_t Vertices::compactRecordsAndDie(Indices& indices) {
+  std::vector<idx> renumbered;
+  const size_t nv = renumber(renumbered);
+  std::vector<idx> vertexAt(nv);
+  for (idx v = 0; v < size(); ++v)
+    if (exists(v)) vertexAt[renumbered[v]] = v;
+  for (auto& face : indices)
+    for (idx& v : face) v = renumbered[v];
+
+  // the vertex written at i is at i or after it, but its origin can be
+  // before, e.g., if it took the place of a fixed vertex, in which case the
+  // record of the origin is written over first and is saved here
+  std::vector<char> saved;
+  for (idx i = 0; i < nv; ++i) {
+    const char* record = _records + origin(vertexAt[i]) * _stride;
+    if (origin(vertexAt[i]) < i)
+      saved.insert(saved.end(), record, record + _stride);
+  }
+
+  const char* nextSaved = saved.data();
+  for (idx i = 0; i < nv; ++i) {
+    const idx v = vertexAt[i], o = origin(v);
+    const vec3d pos = position(v);
+    char* record = _records + i * _stride;
+    if (o < i) {
+      std::memcpy(record, nextSaved, _stride);
+      nextSaved += _stride;
+    } else if (o > i) {
+      std::memcpy(record, _records + o * _stride, _stride);
+    }
+    setRecordPosition(i, pos);
+  }
+  return nv;
+}
+
+void Vertices::compactPositionsAndDie(Positions& positions, Indices& indices,
+                                      std::vector<idx>* origins) {
+  compact(indices);
+  if (_positionsF.empty()) {
+    positions = std::move(_positions);
+  } else {
+    positions.resize(_positionsF.size());
+    for (idx v = 0; v < positions.size(); ++v) positions[v] = position(v);
+  }
+  if (origins) *origins = std::move(_origins);
+}
+
+void Vertices::compactPositionsAndDie(PositionsF& positions, Indices& indices,
+                                      std::vector<idx>* origins) {
+  compact(indices);
+  if (!_positionsF.empty()) {
+    positions = std::move(_positionsF);
+  } else {
+    positions.resize(_positions.size());
+    for (idx v = 0; v < positions.size(); ++v)
+      positions[v] = {static_cast<float>(_positions[v][0]),
+                      static_cast<float>(_positions[v][1]),
+                      static_cast<float>(_positions[v][2])};
   }
+  if (origins) *origins = std::move(_origins);
 }
 
 }  // namespace Internal
@@ -6,11 +6,13 @@
 #define MESH_SIMPL_VERTICES_HPP
 
 #include <ext/alloc_traits.h>
+#include <cstring>
 #include <utility>
 #include <vector>
 
 #include "erasable.hpp"
 #include "faces.hpp"
+#include "numa.hpp"
 #include "quadric.hpp"
 #include "types.hpp"
 
@@ -19,29 +21,130 @@ namespace Internal {
 
 class Vertices : public Erasables {
  private:
+  // positions and quadrics are stored in float instead if single precision
   Positions _positions;
-  std::vector<Quadric> _quadrics;
-  std::vector<bool> _boundary;
-  std::vector<bool> _fixed;
+  PositionsF _positionsF;
+  Array<Quadric> _quadrics;
+  Array<Quadric::Compact> _quadricsF;  // relative to _center
+  vec3d _center{};
+  Array<bool> _boundary;
+  Array<bool> _fixed;
+  std::vector<idx> _origins;
+  bool _withQuadrics;
+
+  // records of a caller's vertex buffer beginning with the positions, which
+  // are read and written there unless vertices were added, see duplicate()
+  char* _records = nullptr;
+  size_t _stride = 0;
+  bool _recordsSingle = false;
+  bool _inRecords = false;
+
+  // Reorder positions and origins as compactPositionsAndDie()
+  void compact(Indices& indices);
+
+  // Set the quadric center to that of the bounding box
+  void centerQuadrics();
+
+  // Get/set position of a vertex in its record
+  vec3d recordPosition(idx v) const {
+    const char* record = _records + v * _stride;
+    if (!_recordsSingle) {
+      vec3d pos;
+      std::memcpy(pos.data(), record, sizeof(pos));
+      return pos;
+    }
+    vec3f pos;
+    std::memcpy(pos.data(), record, sizeof(pos));
+    return {pos[0], pos[1], pos[2]};
+  }
+  void setRecordPosition(idx v, const vec3d& pos) {
+    char* record = _records + v * _stride;
+    if (!_recordsSingle) {
+      std::memcpy(record, pos.data(), sizeof(pos));
+      return;
+    }
+    const vec3f posF = {static_cast<float>(pos[0]), static_cast<float>(pos[1]),
+                        static_cast<float>(pos[2])};
+    std::memcpy(record, posF.data(), sizeof(posF));
+  }
+
+  // Copy positions out of the records into _positions or _positionsF
+  void leaveRecords();
 
  public:
-  // Embed positions and allocate space for quadrics
-  explicit Vertices(Positions& positions)
+  // Embed positions and allocate space for quadrics unless not withQuadrics,
+  // in which case quadrics must not be accessed
+  explicit Vertices(Positions& positions, bool withQuadrics = true)
       : Erasables(positions.size()),
         _positions(std::move(positions)),
-        _quadrics(size()),
+        _quadrics(withQuadrics ? size() : 0),
         _boundary(size(), false),
-        _fixed(size(), false) {}
+        _fixed(size(), false),
+        _withQuadrics(withQuadrics) {}
+
+  // Embed single precision positions; quadrics are stored in float as well,
+  // relative to the center of the bounding box so that their rounding does
+  // not grow with the distance of the mesh from the origin, and both are
+  // widened to double when read
+  explicit Vertices(PositionsF& positions, bool withQuadrics = true);
+
+  // Embed the positions in the records of a vertex buffer, `stride` bytes
+  // apart, without copying them; they are stored in float or double, with
+  // quadrics, as by the constructors above. Records are the caller's until
+  // compactRecordsAndDie() and must not be accessed meanwhile
+  Vertices(const VertexBuffer& buffer, size_t stride,
+           bool withQuadrics = true);
+
+  // Embed other positions, copied into the storage of the ones before, and
+  // clear quadrics, flags and origins
+  void reset(const Positions& positions) {
+    _erased.assign(positions.size(), false);
+    _positions.assign(positions.begin(), positions.end());
+    _positionsF.clear();
+    _records = nullptr;
+    _inRecords = false;
+    _quadrics.assign(_withQuadrics ? size() : 0, Quadric());
+    _quadricsF.clear();
+    _boundary.assign(size(), false);
+    _fixed.assign(size(), false);
+    _origins.clear();
+  }
 
   // Get/set position of a vertex
-  const vec3d& position(idx v) const { return _positions[v]; }
-  const vec3d& operator[](idx v) const { return position(v); }
-  void setPosition(idx v, const vec3d& pos) { _positions[v] = pos; }
+  vec3d position(idx v) const {
+    if (_inRecords) return recordPosition(v);
+    if (_positionsF.empty()) return _positions[v];
+    const vec3f& pos = _positionsF[v];
+    return {pos[0], pos[1], pos[2]};
+  }
+  vec3d operator[](idx v) const { return position(v); }
+  void setPosition(idx v, const vec3d& pos) {
+    if (_inRecords)
+      setRecordPosition(v, pos);
+    else if (_positionsF.empty())
+      _positions[v] = pos;
+    else
+      _positionsF[v] = {static_cast<float>(pos[0]), static_cast<float>(pos[1]),
+                        static_cast<float>(pos[2])};
+  }
 
   // Get/set quadric of a vertex
-  const Quadric& q(idx v) const { return _quadrics[v]; }
+  Quadric q(idx v) const {
+    if (_quadricsF.empty()) return _quadrics[v];
+    return Quadric(_quadricsF[v])
+        .translated({-_center[0], -_center[1], -_center[2]});
+  }
   void increaseQ(idx v, const Quadric& by) { setQ(v, q(v) + by); }
-  void setQ(idx v, const Quadric& val) { _quadrics[v] = val; }
+  void setQ(idx v, const Quadric& val) {
+    if (_quadricsF.empty())
+      _quadrics[v] = val;
+    else
+      _quadricsF[v] = val.translated(_center).compact();
+  }
+
+  // If quadrics are rounded whenever they are set, in which case sums of
+  // many terms should be taken before setting them
+  bool roundsQuadrics() const { return !_quadricsF.empty(); }
 
   // Get/set if a vertex is on boundary
   bool isBoundary(idx v) const { return _boundary[v]; }
@@ -51,9 +154,21 @@ class Vertices : public Erasables {
   bool isFixed(idx v) const { return _fixed[v]; }
   void setFixed(idx v, bool b) { _fixed[v] = b; }
 
+  // Start tracking origins: every vertex is its own origin, and a vertex that
+  // takes the place of a fixed one takes its origin too
+  void trackOrigins() {
+    _origins.resize(size());
+    for (idx v = 0; v < size(); ++v) _origins[v] = v;
+  }
+
+  // Get/set the origin of a vertex, if they are tracked
+  bool tracksOrigins() const { return !_origins.empty(); }
+  idx origin(idx v) const { return _origins[v]; }
+  void setOrigin(idx v, idx o) { _origins[v] = o; }
+
   // Erase unreferenced vertices
   void eraseUnref(const Faces& faces) {
-    _erased = std::vector<bool>(size(), true);
+    _erased.assign(size(), true);
     for (idx f = 0; f < faces.size(); ++f) {
       if (faces.exists(f)) {
         for (idx v : faces[f]) {
@@ -63,19 +178,63 @@ class Vertices : public Erasables {
     }
   }
 
-  void reduceQByHalf(idx v) { _quadrics[v] *= 0.5; }
+  void reduceQByHalf(idx v) {
+    if (!_withQuadrics) return;
+    if (!_quadricsF.empty()) {
+      for (float& value : _quadricsF[v]) value *= 0.5f;
+      return;
+    }
+    _quadrics[v] *= 0.5;
+  }
 
   idx duplicate(idx src) {
+    if (_inRecords) leaveRecords();
     idx v = size();
     _erased.push_back(false);
-    _positions.push_back(_positions[src]);
-    _quadrics.push_back(_quadrics[src]);
+    if (_positionsF.empty())
+      _positions.push_back(_positions[src]);
+    else
+      _positionsF.push_back(_positionsF[src]);
+    if (!_quadrics.empty()) _quadrics.push_back(_quadrics[src]);
+    if (!_quadricsF.empty()) _quadricsF.push_back(_quadricsF[src]);
     _boundary.push_back(_boundary[src]);
     _fixed.push_back(_fixed[src]);
+    if (!_origins.empty()) _origins.push_back(_origins[src]);
     return v;
   }
 
-  void compactPositionsAndDie(Positions& positions, Indices& indices);
+  // Move positions of vertices not erased, and their origins if tracked, to
+  // the output and renumber indices accordingly
+  void compactPositionsAndDie(Positions& positions, Indices& indices,
+                              std::vector<idx>* origins = nullptr);
+  void compactPositionsAndDie(PositionsF& positions, Indices& indices,
+                              std::vector<idx>* origins = nullptr);
+
+  // Write vertices not erased to the front of the records embedded, each
+  // into the record of its origin, which must be tracked, and with its
+  // position, and renumber indices accordingly. Records of erased vertices
+  // are overwritten or left as they are. Returns the number of vertices;
+  // there must be no more than the records
+  size_t compactRecordsAndDie(Indices& indices);
+
+  // Number each vertex not erased as compactPositionsAndDie() does, indexed
+  // by its current number; returns the number of vertices not erased
+  size_t renumber(std::vector<idx>& renumbered) const;
+
+  // Write positions of vertices not erased, and their origins if given, as
+  // compactPositionsAndDie() without modifying them; `renumbered` receives
+  // their numbers, see renumber()
+  void writeCompacted(std::vector<idx>& renumbered, vec3d* positions,
+                      idx* origins = nullptr) const;
+
+  // Place positions and quadrics on NUMA nodes, see NumaLayout
+  void place(const NumaLayout& numa, MemoryPlacement placement,
+             unsigned parts) const {
+    numa.place(_positions, placement, parts);
+    numa.place(_positionsF, placement, parts);
+    numa.place(_quadrics, placement, parts);
+    numa.place(_quadricsF, placement, parts);
+  }
 };
 
 }  // namespace Internal
@@ -0,0 +1,127 @@
+// simplify() in-place in an interleaved vertex buffer
+
+#include <cstdint>
+#include <vector>
+
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+// A vertex with an attribute that must follow its position
+template <typename T>
+struct Record {
+  T position[3];
+  T id;
+};
+
+// Simplify the torus in a buffer of records whose attribute is the input
+// vertex number, and check that every output record is that of an input
+// vertex and its indices are in the output
+template <typename T, typename I>
+static void simplifyTorus(float strength, unsigned threads,
+                          bool keepVertices = false) {
+  Positions positions;
+  Indices faces;
+  torus(60, 30, 4, 1, {0, 0, 0}, positions, faces);
+  std::vector<Record<T>> records(positions.size());
+  for (size_t v = 0; v < positions.size(); ++v) {
+    for (int i = 0; i < 3; ++i)
+      records[v].position[i] = static_cast<T>(positions[v][i]);
+    records[v].id = static_cast<T>(v);
+  }
+  std::vector<I> indices;
+  for (const vec3i& face : faces)
+    for (idx v : face) indices.push_back(static_cast<I>(v));
+
+  VertexBuffer buffer;
+  buffer.data = records.data();
+  buffer.count = records.size();
+  buffer.stride = sizeof(Record<T>);
+  buffer.doublePrecision = sizeof(T) == sizeof(double);
+  SimplifyOptions options;
+  options.strength = strength;
+  options.threads = threads;
+  options.keepVertices = keepVertices;
+  const MeshSize size = simplify(buffer, indices.data(), faces.size(), options);
+
+  CHECK(size.faces <= faces.size() * (1 - strength) + 2);
+  CHECK(size.vertices <= records.size());
+  for (size_t i = 0; i < 3 * size.faces; ++i)
+    CHECK(indices[i] < size.vertices);
+  for (size_t v = 0; v < size.vertices; ++v) {
+    const T id = records[v].id;
+    CHECK(id >= 0 && id < positions.size() && id == static_cast<size_t>(id));
+    // kept vertices take the records of the input vertices they are at
+    if (keepVertices)
+      for (int i = 0; i < 3; ++i)
+        CHECK(records[v].position[i] == static_cast<T>(positions[id][i]));
+  }
+}
+
+// The buffer gives the result of simplify() on vectors, also if vertices are
+// split to fix the topology
+static void compareWithVectors(float strength, bool topologyModifiable) {
+  Positions positions;
+  Indices faces;
+  torus(16, 8, 4, 1, {0, 0, 0}, positions, faces);
+  Positions records = positions;
+  std::vector<uint32_t> indices;
+  for (const vec3i& face : faces)
+    for (idx v : face) indices.push_back(static_cast<uint32_t>(v));
+
+  SimplifyOptions options;
+  options.strength = strength;
+  options.topologyModifiable = topologyModifiable;
+  VertexBuffer buffer;
+  buffer.data = records.data();
+  buffer.count = records.size();
+  buffer.doublePrecision = true;
+  const MeshSize size = simplify(buffer, indices.data(), faces.size(), options);
+  simplify(positions, faces, options);
+
+  CHECK(size.vertices == positions.size());
+  CHECK(size.faces == faces.size());
+  if (size.vertices != positions.size() || size.faces != faces.size()) return;
+  records.resize(size.vertices);
+  CHECK(records == positions);
+  for (size_t f = 0; f < size.faces; ++f)
+    for (order k = 0; k < 3; ++k) CHECK(indices[3 * f + k] == faces[f][k]);
+}
+
+// A single face simplified away leaves empty buffers
+template <typename I>
+static void simplifyTriangle() {
+  std::vector<Record<float>> records = {
+      {{0, 0, 0}, 0}, {{1, 0, 0}, 1}, {{0, 1, 0}, 2}};
+  std::vector<I> indices = {0, 1, 2};
+  VertexBuffer buffer;
+  buffer.data = records.data();
+  buffer.count = records.size();
+  buffer.stride = sizeof(Record<float>);
+  SimplifyOptions options;
+  options.strength = 1;
+  const MeshSize size = simplify(buffer, indices.data(), 1, options);
+  CHECK(size.faces == 0);
+  CHECK(size.vertices == 0);
+}
+
+int main() {
+  for (unsigned threads : {1u, 4u}) {
+    simplifyTorus<float, uint16_t>(0.9f, threads);
+    simplifyTorus<float, uint32_t>(0.5f, threads);
+    simplifyTorus<double, uint32_t>(0.9f, threads);
+    simplifyTorus<float, uint64_t>(0.5f, threads);
+    simplifyTorus<float, uint32_t>(0.9f, threads, true);
+    simplifyTorus<double, uint32_t>(0.5f, threads, true);
+  }
+  for (float strength : {0.5f, 0.9f, 0.97f})
+    for (bool topologyModifiable : {false, true})
+      compareWithVectors(strength, topologyModifiable);
+  simplifyTriangle<uint16_t>();
+  simplifyTriangle<uint32_t>();
+  simplifyTriangle<uint64_t>();
+  return testResult();
+}
@@ -0,0 +1,75 @@
+#include <stdexcept>
+
+#include <progressive.hpp>
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+// `count` disjoint tori in one mesh
+static void tori(size_t count, Positions& positions, Indices& indices) {
+  positions.clear();
+  indices.clear();
+  for (size_t m = 0; m < count; ++m) {
+    Positions p;
+    Indices i;
+    torus(30 + 4 * m, 20, 4, 1, {10.0 * m, 0, 0}, p, i);
+    const idx offset = positions.size();
+    positions.insert(positions.end(), p.begin(), p.end());
+    for (vec3i face : i) {
+      for (order k = 0; k < 3; ++k) face[k] += offset;
+      indices.push_back(face);
+    }
+  }
+}
+
+// add a component of three faces on one edge
+static void addNonManifold(Positions& positions, Indices& indices) {
+  const idx o = positions.size();
+  positions.insert(positions.end(), {{100, 0, 0},
+                                     {101, 0, 0},
+                                     {100, 1, 0},
+                                     {100, -1, 0},
+                                     {100, 0, 1}});
+  indices.insert(indices.end(), {{{o, o + 1, o + 2}},
+                                 {{o + 1, o, o + 3}},
+                                 {{o, o + 1, o + 4}}});
+}
+
+int main() {
+  for (bool shareBudget : {false, true})
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+      SimplifyOptions options;
+      options.threads = threads;
+      options.strength = 0.75f;
+
+      Positions positions;
+      Indices indices;
+      tori(8, positions, indices);
+      const size_t faces = indices.size();
+      simplifyComponents(positions, indices, options, shareBudget);
+      CHECK(indices.size() <= faces / 4 + 8);
+      CHECK(indices.size() > 0);
+
+      // a collapse log is not written by simplifyComponents()
+      CollapseLog log;
+      SimplifyOptions logged = options;
+      logged.collapseLog = &log;
+      Positions loggedPositions;
+      Indices loggedIndices;
+      tori(8, loggedPositions, loggedIndices);
+      simplifyComponents(loggedPositions, loggedIndices, logged, shareBudget);
+      CHECK(hash(loggedPositions, loggedIndices) == hash(positions, indices));
+      CHECK(log.splits.empty() && log.baseFaces == 0);
+
+      // an invalid component throws on whichever thread simplifies it
+      tori(8, positions, indices);
+      addNonManifold(positions, indices);
+      CHECK_THROWS(
+          simplifyComponents(positions, indices, options, shareBudget),
+          std::invalid_argument);
+    }
+  return testResult();
+}
@@ -0,0 +1,37 @@
+// The output of simplify() does not depend on the number of threads
+
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+static uint64_t simplifiedHash(SimplifyOptions options, unsigned threads) {
+  Positions positions;
+  Indices indices;
+  torus(120, 60, 4, 1, {0, 0, 0}, positions, indices);
+  options.strength = 0.9f;
+  options.threads = threads;
+  simplify(positions, indices, options);
+  return hash(positions, indices);
+}
+
+int main() {
+  SimplifyOptions plain;
+  SimplifyOptions topology;
+  topology.topologyModifiable = true;
+  topology.weightByArea = true;
+  SimplifyOptions memoryless;
+  memoryless.memoryless = true;
+  SimplifyOptions bucketed;
+  bucketed.bucketWidth = 0.1f;
+
+  for (const SimplifyOptions* options :
+       {&plain, &topology, &memoryless, &bucketed}) {
+    const uint64_t serial = simplifiedHash(*options, 1);
+    for (unsigned threads : {2u, 8u, 32u})
+      CHECK(simplifiedHash(*options, threads) == serial);
+  }
+  return testResult();
+}
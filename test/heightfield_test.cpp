@@ -0,0 +1,44 @@
+// simplifyHeightfield() keeps the border of a tile and rejects options it
+// does not support
+
+#include <cmath>
+#include <stdexcept>
+
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+int main() {
+  Heightfield field;
+  field.width = 33;
+  field.height = 17;
+  for (size_t j = 0; j < field.height; ++j)
+    for (size_t i = 0; i < field.width; ++i)
+      field.heights.push_back(std::sin(0.3 * i) * std::cos(0.2 * j));
+
+  SimplifyOptions options;
+  options.strength = 0.8f;
+  Positions positions;
+  Indices indices;
+  simplifyHeightfield(field, positions, indices, options);
+  CHECK(indices.size() > 0);
+  CHECK(indices.size() < 2 * 32 * 16);
+  // every border sample is kept
+  size_t border = 0;
+  for (const vec3d& p : positions)
+    if (p[0] == 0 || p[1] == 0 || p[0] == 32 || p[1] == 16) ++border;
+  CHECK(border == 2 * (33 + 17) - 4);
+
+  SimplifyOptions clustered = options;
+  clustered.clusterFactor = 4;
+  CHECK_THROWS(simplifyHeightfield(field, positions, indices, clustered),
+               std::invalid_argument);
+  SimplifyOptions planar = options;
+  planar.planarRegions = true;
+  CHECK_THROWS(simplifyHeightfield(field, positions, indices, planar),
+               std::invalid_argument);
+  return testResult();
+}
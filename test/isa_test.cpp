@@ -0,0 +1,47 @@
+// The output of simplify() does not depend on the ISA level of the kernels
+
+#include <stdexcept>
+
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+static uint64_t simplifiedHash(SimplifyOptions options, IsaLevel level) {
+  setIsaLevel(level);
+  Positions positions;
+  Indices indices;
+  torus(120, 60, 4, 1, {0.5, -2, 3}, positions, indices);
+  // an open border, so that border quadrics are used
+  indices.resize(indices.size() - 120);
+  options.strength = 0.9f;
+  simplify(positions, indices, options);
+  return hash(positions, indices);
+}
+
+int main() {
+  SimplifyOptions plain;
+  SimplifyOptions topology;
+  topology.topologyModifiable = true;
+  topology.weightByArea = true;
+  SimplifyOptions memoryless;
+  memoryless.memoryless = true;
+  memoryless.fixBoundary = false;
+  SimplifyOptions bucketed;
+  bucketed.bucketWidth = 0.1f;
+
+  const IsaLevel supported = supportedIsaLevel();
+  for (const SimplifyOptions* options :
+       {&plain, &topology, &memoryless, &bucketed}) {
+    const uint64_t generic = simplifiedHash(*options, IsaLevel::GENERIC);
+    for (IsaLevel level : {IsaLevel::SSE42, IsaLevel::AVX2, IsaLevel::AVX512})
+      if (level <= supported)
+        CHECK(simplifiedHash(*options, level) == generic);
+  }
+  if (supported < IsaLevel::AVX512)
+    CHECK_THROWS(setIsaLevel(IsaLevel::AVX512), std::invalid_argument);
+  setIsaLevel(supported);
+  return testResult();
+}
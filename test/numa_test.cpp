@@ -0,0 +1,94 @@
+// NUMA nodes are read from sysfs and memory is placed on them by kernel id
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <numa.hpp>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimpl::Internal;
+using namespace MeshSimplTest;
+
+#ifdef __linux__
+
+// A sysfs node directory of online nodes 0 to 3, where node 1 has memory only
+static std::string fakeSysfs() {
+  char dir[] = "/tmp/numa_test.XXXXXX";
+  if (!mkdtemp(dir)) return "";
+  const std::string root = std::string(dir) + "/";
+  std::ofstream(root + "online") << "0-3\n";
+  const char* cpus[] = {"0-3", "", "4-5,8", "6-7"};
+  for (int node = 0; node < 4; ++node) {
+    const std::string nodeDir = root + "node" + std::to_string(node);
+    mkdir(nodeDir.c_str(), 0700);
+    std::ofstream(nodeDir + "/cpulist") << cpus[node] << "\n";
+  }
+  return root;
+}
+
+static void testLayout() {
+  const std::string root = fakeSysfs();
+  CHECK(!root.empty());
+  const NumaLayout numa(root);
+  CHECK(numa.nodes() == 3);
+  CHECK(numa.id(0) == 0 && numa.id(1) == 2 && numa.id(2) == 3);
+  CHECK(numa.nodeOf(0, 6) == 0 && numa.nodeOf(2, 6) == 1);
+  CHECK(numa.nodeOf(5, 6) == 2);
+
+  // masks hold kernel ids, not positions among nodes with CPUs
+  CHECK(numa.mask({1}) == std::vector<unsigned long>{1UL << 2});
+  CHECK(numa.mask({0, 2}) == std::vector<unsigned long>{1UL | 1UL << 3});
+  CHECK(numa.mask({}) == std::vector<unsigned long>{0});
+
+  const std::string remove = "rm -r " + root;
+  CHECK(std::system(remove.c_str()) == 0);
+}
+
+// Kernel id of the node holding the page at `address`
+static int nodeOfPage(const void* address) {
+  int node = -1;
+  syscall(SYS_get_mempolicy, &node, nullptr, 0, address,
+          MPOL_F_NODE | MPOL_F_ADDR);
+  return node;
+}
+
+// Each part of a partitioned range is on the node of the thread of that part
+static void testPartition() {
+  const NumaLayout numa;
+  const size_t page = sysconf(_SC_PAGESIZE), pagesPerPart = 16;
+  const unsigned parts = 2 * numa.nodes();
+  std::vector<char> pages(page * (pagesPerPart * parts + 1), 1);
+  char* begin = pages.data() + page - 1;
+  begin -= reinterpret_cast<uintptr_t>(begin) % page;
+  numa.partition(begin, page * pagesPerPart * parts, parts);
+  if (numa.nodes() < 2) return;
+
+  for (unsigned i = 0; i < parts; ++i)
+    for (size_t p = 0; p < pagesPerPart; ++p)
+      CHECK(nodeOfPage(begin + page * (i * pagesPerPart + p)) ==
+            numa.id(numa.nodeOf(i, parts)));
+}
+
+int main() {
+  testLayout();
+  testPartition();
+  return testResult();
+}
+
+#else
+
+int main() { return 0; }
+
+#endif
@@ -0,0 +1,47 @@
+// Simplifying in single precision is about as accurate as in double, also
+// far from the origin
+
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+static const double R = 4, r = 1;
+
+static double simplifiedError(const vec3d& center, bool singlePrecision) {
+  Positions positions;
+  Indices indices;
+  torus(300, 150, R, r, center, positions, indices);
+  SimplifyOptions options;
+  options.strength = 0.95f;
+  if (!singlePrecision) {
+    simplify(positions, indices, options);
+    return torusError(positions, R, r, center);
+  }
+
+  PositionsF positionsF;
+  for (const vec3d& pos : positions)
+    positionsF.push_back({static_cast<float>(pos[0]),
+                          static_cast<float>(pos[1]),
+                          static_cast<float>(pos[2])});
+  simplify(positionsF, indices, options);
+  positions.clear();
+  for (const vec3f& pos : positionsF)
+    positions.push_back({pos[0], pos[1], pos[2]});
+  return torusError(positions, R, r, center);
+}
+
+int main() {
+  for (double offset : {0.0, 1000.0, 10000.0}) {
+    const vec3d center{offset, offset / 2, -offset};
+    const double error = simplifiedError(center, false);
+    const double errorF = simplifiedError(center, true);
+    std::cerr << "offset " << offset << ": max error " << error
+              << " in double, " << errorF << " in float" << std::endl;
+    CHECK(error < 0.02);
+    CHECK(errorF < 1.25 * error);
+  }
+  return testResult();
+}
@@ -0,0 +1,88 @@
+// A collapse log read back refines the base mesh into the input, and a
+// corrupt or truncated log is rejected instead of indexing out of bounds
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <progressive.hpp>
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+// a log read from `bytes` after `change` edited them
+template <typename Change>
+static void readChanged(const std::string& bytes, Change change) {
+  std::string changed = bytes;
+  change(changed);
+  std::istringstream is(changed);
+  CollapseLog log;
+  log.read(is);
+}
+
+int main() {
+  Positions input;
+  Indices inputIndices;
+  torus(40, 20, 4, 1, {0, 0, 0}, input, inputIndices);
+  Positions positions = input;
+  Indices indices = inputIndices;
+  CollapseLog written;
+  SimplifyOptions options;
+  options.strength = 0.9f;
+  options.collapseLog = &written;
+  simplify(positions, indices, options);
+
+  std::ostringstream os;
+  written.write(os);
+  const std::string bytes = os.str();
+  CHECK(bytes.size() == written.bytes());
+
+  std::istringstream is(bytes);
+  CollapseLog log;
+  log.read(is);
+  ProgressiveMesh mesh(positions, indices, log);
+  mesh.setLevel(mesh.levels());
+  CHECK(mesh.vertexCount() == input.size());
+  CHECK(mesh.faceCount() == inputIndices.size());
+
+  // truncated anywhere
+  for (size_t size : {size_t(3), size_t(20), bytes.size() / 2,
+                      bytes.size() - 1})
+    CHECK_THROWS(
+        readChanged(bytes, [&](std::string& s) { s.resize(size); }),
+        std::runtime_error);
+
+  // a huge count of splits, after magic, version, index size and the two
+  // base sizes
+  const size_t splitCount = 4 + 2 * 4 + 2 * 8;
+  CHECK_THROWS(readChanged(bytes,
+                           [&](std::string& s) {
+                             for (size_t i = 0; i < 8; ++i)
+                               s[splitCount + i] = '\x7f';
+                           }),
+               std::runtime_error);
+
+  // the kept vertex of the first split out of range
+  const size_t firstSplit = 4 + 2 * 4 + 7 * 8;
+  CHECK_THROWS(readChanged(bytes,
+                           [&](std::string& s) {
+                             for (size_t i = 0; i < sizeof(idx); ++i)
+                               s[firstSplit + i] = '\xff';
+                           }),
+               std::runtime_error);
+
+  // the face of the last corner out of range
+  CHECK(!log.corners.empty());
+  const size_t lastCorner = bytes.size() - 2 * sizeof(idx) * log.forks.size() -
+                            3 * sizeof(idx) - sizeof(order);
+  CHECK_THROWS(readChanged(bytes,
+                           [&](std::string& s) {
+                             for (size_t i = 0; i < sizeof(idx); ++i)
+                               s[lastCorner + i] = '\xff';
+                           }),
+               std::runtime_error);
+  return testResult();
+}
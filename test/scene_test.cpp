@@ -0,0 +1,51 @@
+#include <stdexcept>
+
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+static std::vector<Mesh> scene(size_t count) {
+  std::vector<Mesh> meshes(count);
+  for (size_t m = 0; m < count; ++m)
+    torus(30 + 4 * m, 20, 4, 1, {10.0 * m, 0, 0}, meshes[m].positions,
+          meshes[m].indices);
+  return meshes;
+}
+
+// three faces on edge (0, 1)
+static Mesh nonManifold() {
+  Mesh mesh;
+  mesh.positions = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}};
+  mesh.indices = {{0, 1, 2}, {1, 0, 3}, {0, 1, 4}};
+  return mesh;
+}
+
+static size_t faceCount(const std::vector<Mesh>& meshes) {
+  size_t count = 0;
+  for (const Mesh& mesh : meshes) count += mesh.indices.size();
+  return count;
+}
+
+int main() {
+  for (unsigned threads : {1u, 2u, 4u, 8u}) {
+    SimplifyOptions options;
+    options.threads = threads;
+
+    std::vector<Mesh> meshes = scene(8);
+    const size_t budget = faceCount(meshes) / 4;
+    simplifyScene(meshes, budget, options);
+    CHECK(faceCount(meshes) <= budget);
+
+    // an invalid mesh throws on whichever thread prepares it
+    for (size_t bad = 0; bad < 8; ++bad) {
+      meshes = scene(8);
+      meshes[bad] = nonManifold();
+      CHECK_THROWS(simplifyScene(meshes, budget, options),
+                   std::invalid_argument);
+    }
+  }
+  return testResult();
+}
@@ -0,0 +1,33 @@
+// A Simplifier reused over meshes of different sizes writes what simplify()
+// outputs for each, including when the queue keeps buckets of earlier meshes
+
+#include <simplifier.hpp>
+#include <simplify.hpp>
+
+#include "test.hpp"
+
+using namespace MeshSimpl;
+using namespace MeshSimplTest;
+
+int main() {
+  for (float bucketWidth : {0.0f, 0.1f, 0.001f}) {
+    SimplifyOptions options;
+    options.strength = 0.8f;
+    options.bucketWidth = bucketWidth;
+    Simplifier simplifier(options);
+    for (int n : {60, 12, 30, 8, 60}) {
+      Positions positions;
+      Indices indices;
+      torus(2 * n, n, 4, 1, {0, 0, 0}, positions, indices);
+
+      const MeshSize size = simplifier.simplify(positions, indices);
+      Positions written(size.vertices);
+      Indices writtenIndices(size.faces);
+      simplifier.write(written.data(), writtenIndices.data());
+
+      simplify(positions, indices, options);
+      CHECK(hash(written, writtenIndices) == hash(positions, indices));
+    }
+  }
+  return testResult();
+}
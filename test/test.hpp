@@ -0,0 +1,106 @@
+#ifndef MESH_SIMPL_TEST_HPP
+#define MESH_SIMPL_TEST_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "types.hpp"
+
+// Minimal checks: a failed check is reported and counted, and the test
+// returns the count from main() through testResult()
+
+namespace MeshSimplTest {
+
+inline int& failures() {
+  static int count = 0;
+  return count;
+}
+
+inline void fail(const char* file, int line, const char* what) {
+  std::cerr << file << ":" << line << ": check failed: " << what << std::endl;
+  ++failures();
+}
+
+inline int testResult() {
+  if (failures() > 0)
+    std::cerr << failures() << " check(s) failed" << std::endl;
+  return failures() > 0 ? 1 : 0;
+}
+
+#define CHECK(condition) \
+  ((condition) ? (void)0 : MeshSimplTest::fail(__FILE__, __LINE__, #condition))
+
+#define CHECK_THROWS(expression, exception)                             \
+  do {                                                                  \
+    bool thrown = false;                                                \
+    try {                                                               \
+      expression;                                                       \
+    } catch (const exception&) {                                        \
+      thrown = true;                                                    \
+    }                                                                   \
+    if (!thrown)                                                        \
+      MeshSimplTest::fail(__FILE__, __LINE__,                           \
+                          #expression " throws " #exception);           \
+  } while (false)
+
+// Closed torus of nu x nv quads, each split in two faces, with major radius
+// R and minor radius r, centered at `center`
+inline void torus(size_t nu, size_t nv, double R, double r,
+                  const MeshSimpl::vec3d& center,
+                  MeshSimpl::Positions& positions,
+                  MeshSimpl::Indices& indices) {
+  const double pi = std::acos(-1.0);
+  positions.clear();
+  indices.clear();
+  for (size_t i = 0; i < nu; ++i)
+    for (size_t j = 0; j < nv; ++j) {
+      // irregular spacing keeps collapse errors from tying everywhere
+      const double u = 2 * pi * (i + 0.3 * std::sin(j * 0.7)) / nu;
+      const double v = 2 * pi * j / nv;
+      positions.push_back({center[0] + (R + r * std::cos(v)) * std::cos(u),
+                           center[1] + (R + r * std::cos(v)) * std::sin(u),
+                           center[2] + r * std::sin(v)});
+    }
+  for (size_t i = 0; i < nu; ++i)
+    for (size_t j = 0; j < nv; ++j) {
+      const MeshSimpl::idx a = i * nv + j, b = i * nv + (j + 1) % nv;
+      const MeshSimpl::idx c = (i + 1) % nu * nv + j;
+      const MeshSimpl::idx d = (i + 1) % nu * nv + (j + 1) % nv;
+      indices.push_back({a, c, d});
+      indices.push_back({a, d, b});
+    }
+}
+
+// Largest distance of a vertex from the surface of torus()
+inline double torusError(const MeshSimpl::Positions& positions, double R,
+                         double r, const MeshSimpl::vec3d& center) {
+  double error = 0;
+  for (const MeshSimpl::vec3d& pos : positions) {
+    const double x = pos[0] - center[0], y = pos[1] - center[1];
+    const double z = pos[2] - center[2];
+    const double ring = std::sqrt(x * x + y * y) - R;
+    error = std::max(error, std::abs(std::sqrt(ring * ring + z * z) - r));
+  }
+  return error;
+}
+
+// FNV-1a hash of the bytes of a mesh
+inline uint64_t hash(const MeshSimpl::Positions& positions,
+                     const MeshSimpl::Indices& indices) {
+  uint64_t h = 14695981039346656037ull;
+  const auto add = [&](const void* data, size_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < bytes; ++i) h = (h ^ p[i]) * 1099511628211ull;
+  };
+  add(positions.data(), positions.size() * sizeof(MeshSimpl::vec3d));
+  add(indices.data(), indices.size() * sizeof(MeshSimpl::vec3i));
+  return h;
+}
+
+}  // namespace MeshSimplTest
+
+#endif  // MESH_SIMPL_TEST_HPP